@@ -10,10 +10,13 @@ public class InventorySystem : ModuleRules
 
 		PublicDependencyModuleNames.AddRange(new string[]
         {
-            "GameplayTags", "Core", "CoreUObject", "Engine"
+            "GameplayTags", "GameplayAbilities", "Core", "CoreUObject", "Engine", "NetCore"
         });
         
         PublicIncludePaths.AddRange(new string[] {"InventorySystem/Public"} );
         PrivateIncludePaths.AddRange(new string[] {"InventorySystem/Private"} );
+
+        // Maximum size in bytes of item data stored inline in inventory items before falling back to the heap
+        PublicDefinitions.Add("INVENTORY_ITEM_DATA_INLINE_SIZE=32");
     }
 }
@@ -4,7 +4,46 @@
 #include "InventorySystem.h"
 #include "Inventory/ItemTypes/ItemTypeBase.h"
 #include "Inventory/InventoryItem.h"
+#include "Inventory/InventorySnapshot.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+
+
+namespace
+{
+	/**
+	 * Groups bulk operation entries by item type, using the same type equality as the inventory array's type index
+	 */
+	struct FItemTypeGroupKeyFuncs : TDefaultMapKeyFuncs<UInventoryItemTypeBase*, FInventoryInlineHandleArray, false>
+	{
+		static bool Matches(KeyInitType A, KeyInitType B) { return A == B || *A == *B; }
+		static uint32 GetKeyHash(KeyInitType Key) { return Key->GetItemTypeHash(); }
+	};
+
+	using FItemTypeGroupMap = TMap<UInventoryItemTypeBase*, FInventoryInlineHandleArray, FDefaultSetAllocator, FItemTypeGroupKeyFuncs>;
+
+	/**
+	 * Maps the unique ID of each item to its current stack count
+	 */
+	TMap<int32, int32> GetStackCounts(const FInventoryInlineHandleArray& Items)
+	{
+		TMap<int32, int32> StackCounts;
+		StackCounts.Reserve(Items.Num());
+
+		for (const FInventoryArrayHandle& ItemHandle : Items)
+		{
+			StackCounts.Add(ItemHandle.GetItemID(), ItemHandle->GetStackCount());
+		}
+
+		return StackCounts;
+	}
+
+	// Number of recently acknowledged prediction keys replicated to the owner
+	constexpr int32 MaxAcknowledgedPredictionKeys = 16;
+}
 
 
 
@@ -16,19 +55,71 @@ UInventoryComponent::UInventoryComponent()
 	// Should be replicated by default
 	SetIsReplicatedByDefault(true);
 
-	// Bind the changed delegate
+	// Bind the changed delegates
 	InventoryArray.InventoryArrayChangedDelegate.BindUObject(this, &UInventoryComponent::OnInventoryArrayChanged);
+	InventoryArray.ItemAddedDelegate.AddUObject(this, &UInventoryComponent::OnInventoryArrayItemAdded);
+	InventoryArray.ItemChangedDelegate.AddUObject(this, &UInventoryComponent::OnInventoryArrayItemChanged);
+	InventoryArray.ItemRemovedDelegate.AddUObject(this, &UInventoryComponent::OnInventoryArrayItemRemoved);
+	InventoryArray.ReplicationDirtyDelegate.BindUObject(this, &UInventoryComponent::OnInventoryArrayReplicationDirty);
+	InventoryArray.ItemIDsReassignedDelegate.BindUObject(this, &UInventoryComponent::OnInventoryArrayItemIDsReassigned);
+	InventoryArray.ResyncRequestedDelegate.BindUObject(this, &UInventoryComponent::OnInventoryArrayResyncRequested);
 }
 
 
 
 // Engine overrides
 
+void UInventoryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	InventoryArray.SetReplicationPageSize(ReplicationPageSize);
+	InventoryArray.SetPagesStreamedPerUpdate(PagesStreamedPerUpdate);
+	UpdatePageSummaries();
+
+	UWorld* World = GetWorld();
+	if (World && GetOwnerRole() == ROLE_Authority && CompactionInterval > 0.f)
+	{
+		World->GetTimerManager().SetTimer(CompactionTimerHandle, this, &UInventoryComponent::OnCompactionTimer, CompactionInterval, true);
+	}
+}
+
+void UInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UWorld* World = GetWorld();
+	if (World)
+	{
+		World->GetTimerManager().ClearTimer(CompactionTimerHandle);
+		World->GetTimerManager().ClearTimer(PredictionTimeoutHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInventoryComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
+{
+	// Handles with cached lookups would otherwise keep resolving into the array until it is garbage collected
+	InventoryArray.InvalidateHandles();
+
+	Super::OnComponentDestroyed(bDestroyingHierarchy);
+}
+
 void UInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(UInventoryComponent, InventoryArray);
+	// All of our properties are push based, and are only compared when they've been explicitly marked dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	// Other clients only get the summary, so the item array is never delta serialized for their connections
+	Params.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, InventoryArray, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, PageSummaries, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, AcknowledgedPredictionKeys, Params);
+
+	Params.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UInventoryComponent, InventorySummary, Params);
 }
 
 
@@ -42,62 +133,53 @@ UInventoryComponent::FAdditionResult UInventoryComponent::AddItem(const FInvento
 		return FAdditionResult(0, FInventoryArrayHandle());
 	}
 
-	UInventoryItemTypeBase* NewItemType = NewItem.GetType();
-	TArray<FInventoryArrayHandle> CurrentItems = GetAllItemsByType(NewItemType);
+	// Only replicate and broadcast once, no matter how many stacks we touch
+	FScopedInventoryBatch Batch(InventoryArray);
 
-	int32 InitialCount = 1;
-	int32 CountLeftToAdd = InitialCount;
+	FInventoryInlineHandleArray CurrentItems;
+	GetAllItemsByType(NewItem.GetType(), CurrentItems);
+	const FAdditionResult Result = AddItemToExisting(NewItem, CurrentItems);
 
-	if (NewItem.AllowsStacking())
-	{
-		// If the item allows stacking, figure out how many we're trying to store
-		InitialCount = NewItem.GetStackCount();
-		CountLeftToAdd = InitialCount;
+	CompactStacksIfOverBudget();
 
-		if (CurrentItems.Num() > 0)
-		{
-			// If there are any existing stacks
-			for (FInventoryArrayHandle ExistingStack : CurrentItems)
-			{
-				// Try to add to the existing stacks until there is nothing left to add
-				const int32 CountAdded = ExistingStack->AddToStack(CountLeftToAdd);
+	return Result;
+}
 
-				if (CountAdded > 0)
-				{
-					// Mark the item dirty on any change
-					CountLeftToAdd -= CountAdded;
-					ExistingStack.MarkDirty();
-				}
+TArray<UInventoryComponent::FAdditionResult> UInventoryComponent::AddItems(TArrayView<const FInventoryItem> NewItems)
+{
+	TArray<FAdditionResult> Results;
+	Results.Reserve(NewItems.Num());
 
-				if (CountLeftToAdd <= 0)
-				{
-					// Early exit if there is nothing left to add
-					return FAdditionResult(InitialCount, FInventoryArrayHandle());
-				}
-            }
-		}
-	}
+	// Replicate and broadcast once for the whole batch
+	FScopedInventoryBatch Batch(InventoryArray);
+
+	// Existing items are looked up once per type, and new items are added to the group as they're created so that
+	// later entries of the same type can stack onto them
+	FItemTypeGroupMap TypeGroups;
 
-	if (CurrentItems.Num() > 0)
+	for (const FInventoryItem& NewItem : NewItems)
 	{
-		if (!NewItemType->AllowsDuplicates())
+		if (!NewItem.IsValid())
 		{
-			// If the item doesn't allow duplicates, return however many are left to add
-			return FAdditionResult(InitialCount - CountLeftToAdd, FInventoryArrayHandle());
+			Results.Emplace(0, FInventoryArrayHandle());
+			continue;
 		}
-	}
 
-	// Add a new item by copy
-	FInventoryArrayHandle ItemCopy = InventoryArray.Emplace(NewItem);
+		UInventoryItemTypeBase* NewItemType = NewItem.GetType();
+		FInventoryInlineHandleArray* CurrentItems = TypeGroups.Find(NewItemType);
 
-	if (NewItemType->AllowsStacking() && ItemCopy->IsValid())
-	{
-		// If the item can be stacked, set the stack size to the remaining count
-		ItemCopy->SetStackCount(CountLeftToAdd);
-		ItemCopy.MarkDirty();
+		if (!CurrentItems)
+		{
+			CurrentItems = &TypeGroups.Add(NewItemType);
+			GetAllItemsByType(NewItemType, *CurrentItems);
+		}
+
+		Results.Add(AddItemToExisting(NewItem, *CurrentItems));
 	}
-	
-	return TPair<int32, FInventoryArrayHandle>(InitialCount, ItemCopy);
+
+	CompactStacksIfOverBudget();
+
+	return Results;
 }
 
 int32 UInventoryComponent::RemoveItem(UInventoryItemTypeBase* ItemType, int32 Count)
@@ -107,62 +189,120 @@ int32 UInventoryComponent::RemoveItem(UInventoryItemTypeBase* ItemType, int32 Co
 		return 0;
 	}
 
-	int32 CountLeftToRemove = Count;
-	
-	if (ItemType->AllowsStacking())
+	// Only replicate and broadcast once, no matter how many stacks we touch
+	FScopedInventoryBatch Batch(InventoryArray);
+
+	FInventoryInlineHandleArray CurrentItems;
+	GetAllItemsByType(ItemType, CurrentItems);
+	const int32 CountRemoved = RemoveItemFromExisting(ItemType, Count, CurrentItems);
+	RemoveEmptyStacks();
+
+	return CountRemoved;
+}
+
+TArray<int32> UInventoryComponent::RemoveItems(TArrayView<const FRemovalRequest> ItemsToRemove)
+{
+	TArray<int32> Results;
+	Results.Reserve(ItemsToRemove.Num());
+
+	// Replicate and broadcast once for the whole batch
+	FScopedInventoryBatch Batch(InventoryArray);
+
+	FItemTypeGroupMap TypeGroups;
+
+	for (const FRemovalRequest& Request : ItemsToRemove)
 	{
-		// If the item is stackable, try and remove it from the stacks
-		TArray<FInventoryArrayHandle> ExistingStacks = GetAllItemsByType(ItemType);
+		UInventoryItemTypeBase* ItemType = Request.Key;
 
-		for (FInventoryArrayHandle ExistingStack : ExistingStacks)
+		if (!ItemType || Request.Value <= 0)
 		{
-			// Remove until there are no more to remove
-			const int32 CountRemoved = ExistingStack->RemoveFromStack(CountLeftToRemove);
+			Results.Add(0);
+			continue;
+		}
 
-			if (CountRemoved > 0)
-			{
-				// If anything changed mark the existing stack as dirty
-				CountLeftToRemove -= ExistingStack->RemoveFromStack(CountLeftToRemove);
-				ExistingStack.MarkDirty();
-			}
+		FInventoryInlineHandleArray* CurrentItems = TypeGroups.Find(ItemType);
 
-			if (CountLeftToRemove <= 0)
-			{
-				// Early exit if we've already removed everything
-				break;
-			}
+		if (!CurrentItems)
+		{
+			CurrentItems = &TypeGroups.Add(ItemType);
+			GetAllItemsByType(ItemType, *CurrentItems);
 		}
 
-		InventoryArray.RemoveAll([](const FInventoryItem& Item) -> bool
-		{
-			// Remove all empty stacks
-			return Item.GetStackCount() == 0;
-		});
+		Results.Add(RemoveItemFromExisting(ItemType, Request.Value, *CurrentItems));
 	}
-	else
+
+	// Empty stacks stay in place until every entry is processed, so the cached handles stay valid
+	RemoveEmptyStacks();
+
+	return Results;
+}
+
+int32 UInventoryComponent::CompactStacks()
+{
+	// Clients would only mispredict the server's stacks, which replication then overwrites
+	if (GetOwnerRole() != ROLE_Authority)
 	{
-		// Get all items by handle so we can delete them while iterating
-		// (a bit slower, but cleaner)
-		TArray<FInventoryArrayHandle> ExistingItems = GetAllItemsByType(ItemType);
+		return 0;
+	}
+
+	const int32 InitialNum = InventoryArray.Num();
+
+	// Only replicate and broadcast once, no matter how many stacks we touch
+	FScopedInventoryBatch Batch(InventoryArray);
 
-		for (FInventoryArrayHandle ItemHandle : ExistingItems)
+	// Group the stacks by type in array order
+	FItemTypeGroupMap TypeGroups;
+
+	InventoryArray.ForEachHandle([&TypeGroups](const FInventoryArrayHandle& ItemHandle)
+	{
+		if (ItemHandle->AllowsStacking())
+		{
+			TypeGroups.FindOrAdd(ItemHandle->GetType()).Add(ItemHandle);
+		}
+
+		return true;
+	});
+
+	for (TPair<UInventoryItemTypeBase*, FInventoryInlineHandleArray>& TypeGroup : TypeGroups)
+	{
+		FInventoryInlineHandleArray& Stacks = TypeGroup.Value;
+
+		// Pour each stack into the earliest stack that still has room, so every stack is visited once as a source and
+		// once as a target
+		int32 TargetIndex = 0;
+
+		for (int32 SourceIndex = 1; SourceIndex < Stacks.Num(); SourceIndex++)
 		{
-			if (*ItemHandle->GetType() != *ItemType)
+			FInventoryArrayHandle& SourceStack = Stacks[SourceIndex];
+			bool bSourceChanged = false;
+
+			while (TargetIndex < SourceIndex && SourceStack->GetStackCount() > 0)
 			{
-				continue;
+				const int32 CountMoved = Stacks[TargetIndex]->AddToStack(SourceStack->GetStackCount());
+
+				if (CountMoved <= 0)
+				{
+					// The target is full, move on to the next one
+					TargetIndex++;
+					continue;
+				}
+
+				SourceStack->RemoveFromStack(CountMoved);
+				Stacks[TargetIndex].MarkDirty();
+				bSourceChanged = true;
 			}
-			
-			ItemHandle.Remove();
 
-			if (CountLeftToRemove-- <= 0)
+			if (bSourceChanged && SourceStack->GetStackCount() > 0)
 			{
-				// Decrement the count left to remove and exit if we've finished
-				break;
+				// Emptied stacks are about to be removed, so only partially drained stacks need to replicate
+				SourceStack.MarkDirty();
 			}
 		}
 	}
 
-	return CountLeftToRemove;
+	RemoveEmptyStacks();
+
+	return InitialNum - InventoryArray.Num();
 }
 
 TArray<FInventoryItem*> UInventoryComponent::GetAllItemsByTypeTemporary(UInventoryItemTypeBase* ItemType)
@@ -189,79 +329,696 @@ TArray<FInventoryItem*> UInventoryComponent::GetAllItemsByTypeTemporary(UInvento
 	}
 	else
 	{
-		return InventoryArray.FindAllTemporary([ItemType](const FInventoryItem& Item) -> bool
-        {
-            // Add each item pointer if its type matches
-            return *Item.GetType() == *ItemType;
-        });
+		return InventoryArray.FindAllByTypeTemporary(ItemType);
 	}
 }
 
 TArray<FInventoryArrayHandle> UInventoryComponent::GetAllItemsByType(UInventoryItemTypeBase* ItemType)
 {
 	TArray<FInventoryArrayHandle> Result;
+	GetAllItemsByType(ItemType, Result);
+	return Result;
+}
 
+FInventoryItem* UInventoryComponent::GetFirstItemByTypeTemporary(UInventoryItemTypeBase* ItemType)
+{
 	if (!ItemType)
 	{
-		// Return an empty result if the type is invalid
-		return MoveTemp(Result);
+		return nullptr;
 	}
+	
+	return InventoryArray.FindByTypeTemporary(ItemType);
+}
 
-	if (!ItemType->AllowsDuplicates())
+FInventoryArrayHandle UInventoryComponent::GetFirstItemByType(UInventoryItemTypeBase* ItemType)
+{
+	if (!ItemType)
 	{
-		// Find only the first result if the item type doesn't allow duplicates
-		const FInventoryArrayHandle SingleResult = GetFirstItemByType(ItemType);
+		return FInventoryArrayHandle();
+	}
+	
+	return InventoryArray.FindByType(ItemType);
+}
+
+TArray<FInventoryArrayHandle> UInventoryComponent::GetAllItemsByTagQuery(const FGameplayTagQuery& Query)
+{
+	return InventoryArray.FindAllByTagQuery(Query);
+}
+
+TArray<FInventoryItem*> UInventoryComponent::GetAllItemsByTagQueryTemporary(const FGameplayTagQuery& Query)
+{
+	return InventoryArray.FindAllByTagQueryTemporary(Query);
+}
+
+TArray<FInventoryArrayHandle> UInventoryComponent::GetAllItemsByTag(const FGameplayTag& Tag)
+{
+	return InventoryArray.FindAllByTag(Tag);
+}
+
+
+
+// Delegate functions
+
+void UInventoryComponent::OnInventoryArrayChanged()
+{
+	UpdateSummary();
+	UpdatePageSummaries();
+	OnInventoryChanged.Broadcast();
+}
 
-		if (!SingleResult.IsNull())
+void UInventoryComponent::OnInventoryArrayItemAdded(int32 ItemID)
+{
+	// Keep the sorted views up to date before any listeners read them
+	if (SortIndex.IsBuilt())
+	{
+		const FInventoryItem* Item = InventoryArray.GetHandle(ItemID).Get();
+		if (Item)
 		{
-			Result.Add(SingleResult);
+			SortIndex.AddItem(*Item);
 		}
+	}
+
+	MarkSummaryItemsDirty(ItemID, false);
+	OnItemAdded.Broadcast(ItemID);
+}
+
+void UInventoryComponent::OnInventoryArrayItemChanged(int32 ItemID)
+{
+	DiscardPredictedChanges(ItemID);
+
+	if (SortIndex.IsBuilt())
+	{
+		const FInventoryItem* Item = InventoryArray.GetHandle(ItemID).Get();
+		if (Item)
+		{
+			SortIndex.UpdateItem(*Item);
+		}
+	}
+
+	MarkSummaryItemsDirty(ItemID, false);
+	OnItemChanged.Broadcast(ItemID);
+}
+
+void UInventoryComponent::OnInventoryArrayItemRemoved(int32 ItemID)
+{
+	DiscardPredictedChanges(ItemID);
+	SortIndex.RemoveItem(ItemID);
+	MarkSummaryItemsDirty(ItemID, true);
+
+	OnItemRemoved.Broadcast(ItemID);
+}
+
+void UInventoryComponent::OnInventoryArrayReplicationDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, InventoryArray, this);
+}
+
+void UInventoryComponent::OnInventoryArrayItemIDsReassigned()
+{
+	// The summary and sort index are keyed by item ID, so rebuild them from the new IDs. An index that was never used
+	// stays lazy
+	bSummaryItemsDirty = true;
+
+	if (SortIndex.IsBuilt())
+	{
+		SortIndex.Reset();
+		BuildSortIndex();
+	}
+}
+
+void UInventoryComponent::OnInventoryArrayResyncRequested()
+{
+	TArray<int32> ReplicationIDs;
+	InventoryArray.ConsumeResyncRequests(ReplicationIDs);
+
+	if (ReplicationIDs.Num() > 0)
+	{
+		ServerResyncItems(ReplicationIDs);
+	}
+}
+
+
+
+// Sorted views
+
+const TArray<int32>& UInventoryComponent::GetSortedItemIDs(const EInventorySortMode SortMode)
+{
+	if (!SortIndex.IsBuilt())
+	{
+		BuildSortIndex();
+	}
 
+	return SortIndex.GetSortedItemIDs(SortMode);
+}
+
+TArray<int32> UInventoryComponent::SearchItemsByName(const FString& SearchText, EInventorySortMode SortMode)
+{
+	if (!SortIndex.IsBuilt())
+	{
+		BuildSortIndex();
+	}
+
+	TArray<int32> Result;
+	SortIndex.SearchByName(SearchText, SortMode, Result);
+	return Result;
+}
+
+
+
+// Aggregates
+
+int32 UInventoryComponent::GetCountWithinWeightLimit(const UInventoryItemTypeBase* ItemType) const
+{
+	if (!ItemType || MaxWeight <= 0.f || ItemType->GetTypeTraits().UnitWeight <= 0.f)
+	{
+		return MAX_int32;
+	}
+
+	// Allow a little slack so that filling up to the limit exactly isn't lost to rounding
+	const double WeightLeft = MaxWeight - InventoryArray.GetAggregates().Weight + KINDA_SMALL_NUMBER;
+	const double CountLeft = FMath::FloorToDouble(WeightLeft / ItemType->GetTypeTraits().UnitWeight);
+
+	return static_cast<int32>(FMath::Clamp<double>(CountLeft, 0.0, MAX_int32));
+}
+
+
+
+// Pagination
+
+void UInventoryComponent::SubscribeToPages(const TArray<int32>& Pages)
+{
+	if (ReplicationPageSize <= 0 || Pages == RequestedPages)
+	{
+		return;
+	}
+
+	RequestedPages = Pages;
+
+	// The server ignores requests for more pages than it streams at once
+	TArray<int32> ClampedPages(Pages.GetData(), FMath::Min(Pages.Num(), FInventoryArray::MaxSubscribedPages));
+
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		InventoryArray.SetSubscribedPages(ClampedPages);
+	}
+	else
+	{
+		ServerSubscribeToPages(ClampedPages);
+	}
+}
+
+
+
+// Persistence
+
+void UInventoryComponent::SaveSnapshot(TArray<uint8>& OutData) const
+{
+	FInventorySnapshot::Write(InventoryArray.GetArray(), OutData);
+}
+
+bool UInventoryComponent::LoadSnapshot(TArray<uint8>&& Data)
+{
+	FInventorySnapshot Snapshot;
+	if (!Snapshot.Read(MoveTemp(Data)))
+	{
+		return false;
+	}
+
+	TArray<FInventoryItem> LoadedItems;
+	Snapshot.MaterializeAll(LoadedItems);
+	ReplaceItems(MoveTemp(LoadedItems));
+	return true;
+}
+
+
+
+// Prediction
+
+UInventoryComponent::FAdditionResult UInventoryComponent::PredictAddItem(const FInventoryItem& NewItem, const FPredictionKey& PredictionKey)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		const FAdditionResult Result = AddItem(NewItem);
+		AcknowledgePrediction(PredictionKey);
 		return Result;
 	}
+
+	if (!NewItem.IsValid() || !PredictionKey.IsLocalClientKey())
+	{
+		return FAdditionResult(0, FInventoryArrayHandle());
+	}
+
+	// Stacks are never compacted here, since that would remove items the server still has
+	FScopedInventoryPrediction Prediction(InventoryArray);
+
+	FInventoryInlineHandleArray CurrentItems;
+	GetAllItemsByType(NewItem.GetType(), CurrentItems);
+	const TMap<int32, int32> PreviousStackCounts = GetStackCounts(CurrentItems);
+
+	const FAdditionResult Result = AddItemToExisting(NewItem, CurrentItems);
+	RecordPredictedOperation(PredictionKey, PreviousStackCounts, CurrentItems);
+
+	return Result;
+}
+
+int32 UInventoryComponent::PredictRemoveItem(UInventoryItemTypeBase* ItemType, int32 Count, const FPredictionKey& PredictionKey)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		const int32 CountRemoved = RemoveItem(ItemType, Count);
+		AcknowledgePrediction(PredictionKey);
+		return CountRemoved;
+	}
+
+	// Removing whole items can't be undone without knowing whether the server removed them as well
+	if (!ItemType || Count <= 0 || !ItemType->GetTypeTraits().bAllowsStacking || !PredictionKey.IsLocalClientKey())
+	{
+		return 0;
+	}
+
+	FScopedInventoryPrediction Prediction(InventoryArray);
+
+	FInventoryInlineHandleArray CurrentItems;
+	GetAllItemsByType(ItemType, CurrentItems);
+	const TMap<int32, int32> PreviousStackCounts = GetStackCounts(CurrentItems);
+
+	// Empty stacks are left in place until the server removes them
+	const int32 CountRemoved = RemoveItemFromExisting(ItemType, Count, CurrentItems);
+	RecordPredictedOperation(PredictionKey, PreviousStackCounts, CurrentItems);
+
+	return CountRemoved;
+}
+
+
+
+// Inventory access helpers
+
+UInventoryComponent::FAdditionResult UInventoryComponent::AddItemToExisting(const FInventoryItem& NewItem, FInventoryInlineHandleArray& ExistingItems)
+{
+	// If the item allows stacking, figure out how many we're trying to store
+	int32 InitialCount = NewItem.AllowsStacking() ? NewItem.GetStackCount() : 1;
+
+	// Limits are checked against the running totals, so rejecting an addition never depends on the inventory's size
+	InitialCount = FMath::Min(InitialCount, GetCountWithinWeightLimit(NewItem.GetType()));
+	if (InitialCount <= 0)
+	{
+		return FAdditionResult(0, FInventoryArrayHandle());
+	}
+
+	int32 CountLeftToAdd = InitialCount;
+
+	// Callers can refer to the stack the items went into, even if no new item was needed
+	FInventoryArrayHandle LastAddedStack;
+
+	if (NewItem.AllowsStacking())
+	{
+		// Try to add to the existing stacks until there is nothing left to add
+		for (FInventoryArrayHandle& ExistingStack : ExistingItems)
+		{
+			const int32 CountAdded = ExistingStack->AddToStack(CountLeftToAdd);
+
+			if (CountAdded > 0)
+			{
+				// Mark the item dirty on any change
+				CountLeftToAdd -= CountAdded;
+				ExistingStack.MarkDirty();
+				LastAddedStack = ExistingStack;
+			}
+
+			if (CountLeftToAdd <= 0)
+			{
+				// Early exit if there is nothing left to add
+				return FAdditionResult(InitialCount, LastAddedStack);
+			}
+		}
+	}
+
+	if (ExistingItems.Num() > 0 && !NewItem.AllowsDuplicates())
+	{
+		// If the item doesn't allow duplicates, return however many were added
+		return FAdditionResult(InitialCount - CountLeftToAdd, LastAddedStack);
+	}
+
+	if (MaxSlots > 0 && GetUsedSlots() + NewItem.GetType()->GetTypeTraits().SlotCost > MaxSlots)
+	{
+		// There is no room for a new item, so only the count added to existing stacks goes in
+		return FAdditionResult(InitialCount - CountLeftToAdd, LastAddedStack);
+	}
+
+	// Add a new item by copy
+	FInventoryArrayHandle ItemCopy = InventoryArray.Emplace(NewItem);
+
+	if (NewItem.AllowsStacking() && ItemCopy->IsValid())
+	{
+		// If the item can be stacked, set the stack size to the remaining count
+		ItemCopy->SetStackCount(CountLeftToAdd);
+		ItemCopy.MarkDirty();
+	}
+
+	ExistingItems.Add(ItemCopy);
+
+	return FAdditionResult(InitialCount, ItemCopy);
+}
+
+int32 UInventoryComponent::RemoveItemFromExisting(UInventoryItemTypeBase* ItemType, const int32 Count, FInventoryInlineHandleArray& ExistingItems)
+{
+	int32 CountLeftToRemove = Count;
+
+	if (ItemType->GetTypeTraits().bAllowsStacking)
+	{
+		// If the item is stackable, remove from the stacks until there are no more to remove
+		for (FInventoryArrayHandle& ExistingStack : ExistingItems)
+		{
+			const int32 CountRemoved = ExistingStack->RemoveFromStack(CountLeftToRemove);
+
+			if (CountRemoved > 0)
+			{
+				// If anything changed mark the existing stack as dirty
+				CountLeftToRemove -= CountRemoved;
+				ExistingStack.MarkDirty();
+			}
+
+			if (CountLeftToRemove <= 0)
+			{
+				// Early exit if we've already removed everything
+				break;
+			}
+		}
+	}
 	else
 	{
-		return InventoryArray.FindAll([ItemType](const FInventoryItem& Item) -> bool
+		// Remove whole items from the front of the list, dropping their handles as they become invalid
+		int32 NumItemsRemoved = 0;
+
+		while (NumItemsRemoved < ExistingItems.Num() && CountLeftToRemove > 0)
 		{
-			// Add each item pointer if its type matches
-			return *Item.GetType() == *ItemType;
-		});
+			ExistingItems[NumItemsRemoved++].Remove();
+			CountLeftToRemove--;
+		}
+
+		ExistingItems.RemoveAt(0, NumItemsRemoved);
 	}
+
+	return Count - CountLeftToRemove;
 }
 
-FInventoryItem* UInventoryComponent::GetFirstItemByTypeTemporary(UInventoryItemTypeBase* ItemType)
+void UInventoryComponent::RemoveEmptyStacks()
 {
-	if (!ItemType)
+	InventoryArray.RemoveAll([](const FInventoryItem& Item) -> bool
 	{
-		return nullptr;
+		return Item.AllowsStacking() && Item.GetStackCount() == 0;
+	});
+}
+
+void UInventoryComponent::CompactStacksIfOverBudget()
+{
+	if (CompactionItemBudget > 0 && InventoryArray.GetArray().Num() > CompactionItemBudget)
+	{
+		CompactStacks();
 	}
-	
-	return InventoryArray.FindTemporary([ItemType](const FInventoryItem& Item)
-    {
-        return *Item.GetType() == *ItemType; 
-    });
 }
 
-FInventoryArrayHandle UInventoryComponent::GetFirstItemByType(UInventoryItemTypeBase* ItemType)
+void UInventoryComponent::OnCompactionTimer()
 {
-	if (!ItemType)
+	CompactStacks();
+}
+
+void UInventoryComponent::UpdateSummary()
+{
+	if (GetOwnerRole() != ROLE_Authority)
 	{
-		return FInventoryArrayHandle();
+		return;
 	}
-	
-	return InventoryArray.Find([ItemType](const FInventoryItem& Item)
+
+	FInventorySummary NewSummary;
+	NewSummary.ItemCount = InventoryArray.GetArray().Num();
+
+	if (!bSummaryItemsDirty)
+	{
+		// No visible item changed, so only the count can be different
+		NewSummary.VisibleItems = InventorySummary.VisibleItems;
+	}
+	else
+	{
+		bSummaryItemsDirty = false;
+		SummaryItemIDs.Reset();
+
+		if (!SummaryItemQuery.IsEmpty() && MaxSummaryItems > 0)
+		{
+			// The tag index finds the matching items without gathering the tags of every item
+			InventoryArray.ForEachHandleByTagQuery(SummaryItemQuery, [this, &NewSummary](const FInventoryArrayHandle& ItemHandle)
+			{
+				// Other clients can only resolve types that replicate by reference
+				const FInventoryItem* Item = ItemHandle.Get();
+				if (Item && Item->IsValid() && Item->GetType()->IsSupportedForNetworking())
+				{
+					FInventorySummaryEntry& Entry = NewSummary.VisibleItems.AddDefaulted_GetRef();
+					Entry.Type = Item->GetType();
+					Entry.StackCount = Item->GetStackCount();
+					SummaryItemIDs.Add(ItemHandle.GetItemID());
+				}
+
+				return NewSummary.VisibleItems.Num() < MaxSummaryItems;
+			});
+		}
+	}
+
+	// Most inventory changes don't affect what other players can see
+	if (NewSummary != InventorySummary)
+	{
+		InventorySummary = MoveTemp(NewSummary);
+		MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, InventorySummary, this);
+	}
+}
+
+void UInventoryComponent::MarkSummaryItemsDirty(const int32 ItemID, const bool bRemoved)
+{
+	if (bSummaryItemsDirty || SummaryItemQuery.IsEmpty() || MaxSummaryItems <= 0 || GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	if (SummaryItemIDs.Contains(ItemID))
+	{
+		bSummaryItemsDirty = true;
+	}
+	else if (!bRemoved)
+	{
+		// The item may have become visible, unless the summary is full and the item comes after all of its items
+		bSummaryItemsDirty = SummaryItemIDs.Num() < MaxSummaryItems
+			|| FInventoryArray::GetItemSlot(ItemID) < FInventoryArray::GetItemSlot(SummaryItemIDs.Last());
+	}
+}
+
+void UInventoryComponent::UpdatePageSummaries()
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		if (InventoryArray.UpdatePageSummaries(PageSummaries))
+		{
+			MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, PageSummaries, this);
+		}
+	}
+}
+
+void UInventoryComponent::BuildSortIndex()
+{
+	SortIndex.Build(InventoryArray.GetArray());
+
+	for (const FInventoryItem& Item : InventoryArray.GetPredictedItems())
+	{
+		SortIndex.AddItem(Item);
+	}
+}
+
+
+
+// Prediction helpers
+
+void UInventoryComponent::RecordPredictedOperation(const FPredictionKey& PredictionKey, const TMap<int32, int32>& PreviousStackCounts, const FInventoryInlineHandleArray& CurrentItems)
+{
+	FPredictedOperation Operation;
+	Operation.PredictionKey = PredictionKey.Current;
+
+	for (const FInventoryArrayHandle& ItemHandle : CurrentItems)
+	{
+		const int32* PreviousStackCount = PreviousStackCounts.Find(ItemHandle.GetItemID());
+
+		if (!PreviousStackCount)
+		{
+			Operation.CreatedItemIDs.Add(ItemHandle.GetItemID());
+			continue;
+		}
+
+		const int32 CountChange = ItemHandle->GetStackCount() - *PreviousStackCount;
+		if (CountChange != 0)
+		{
+			Operation.StackChanges.Emplace(ItemHandle.GetItemID(), CountChange);
+		}
+	}
+
+	if (Operation.StackChanges.Num() == 0 && Operation.CreatedItemIDs.Num() == 0)
+	{
+		// Nothing changed, so there is nothing to undo
+		return;
+	}
+
+	PredictedOperations.Add(MoveTemp(Operation));
+
+	// Both events forget the operations for the key once handled, so binding them again for a shared key is harmless
+	FPredictionKey BoundKey = PredictionKey;
+	BoundKey.NewRejectedDelegate().BindUObject(this, &UInventoryComponent::OnPredictionRejected, PredictionKey.Current);
+	BoundKey.NewCaughtUpDelegate().BindUObject(this, &UInventoryComponent::OnPredictionCaughtUp, PredictionKey.Current);
+}
+
+void UInventoryComponent::RevertPredictedOperation(const FPredictedOperation& Operation)
+{
+	for (const TPair<int32, int32>& StackChange : Operation.StackChanges)
+	{
+		FInventoryArrayHandle ItemHandle = InventoryArray.GetHandle(StackChange.Key);
+		if (!ItemHandle.Get())
+		{
+			continue;
+		}
+
+		if (StackChange.Value > 0)
+		{
+			ItemHandle->RemoveFromStack(StackChange.Value);
+		}
+		else
+		{
+			ItemHandle->AddToStack(-StackChange.Value);
+		}
+
+		ItemHandle.MarkDirty();
+	}
+
+	for (const int32 ItemID : Operation.CreatedItemIDs)
+	{
+		FInventoryArrayHandle ItemHandle = InventoryArray.GetHandle(ItemID);
+		if (ItemHandle.Get())
+		{
+			ItemHandle.Remove();
+		}
+	}
+}
+
+void UInventoryComponent::ResolvePredictedOperations(TFunctionRef<bool(const FPredictedOperation&)> Predicate)
+{
+	// Reverting is itself a predicted change, so that it isn't mistaken for the server's state
+	FScopedInventoryPrediction Prediction(InventoryArray);
+
+	// Undo the newest operations first
+	for (int32 Index = PredictedOperations.Num() - 1; Index >= 0; Index--)
+	{
+		if (Predicate(PredictedOperations[Index]))
+		{
+			RevertPredictedOperation(PredictedOperations[Index]);
+			PredictedOperations.RemoveAt(Index);
+		}
+	}
+}
+
+void UInventoryComponent::DiscardPredictedChanges(const int32 ItemID)
+{
+	if (PredictedOperations.Num() == 0 || InventoryArray.IsPredictingChanges())
+	{
+		return;
+	}
+
+	for (FPredictedOperation& Operation : PredictedOperations)
+	{
+		Operation.StackChanges.RemoveAll([ItemID](const TPair<int32, int32>& StackChange)
+		{
+			return StackChange.Key == ItemID;
+		});
+	}
+}
+
+void UInventoryComponent::AcknowledgePrediction(const FPredictionKey& PredictionKey)
+{
+	if (!PredictionKey.IsValidKey() || PredictionKey.IsServerInitiatedKey())
+	{
+		return;
+	}
+
+	if (AcknowledgedPredictionKeys.Num() >= MaxAcknowledgedPredictionKeys)
+	{
+		AcknowledgedPredictionKeys.RemoveAt(0, AcknowledgedPredictionKeys.Num() - MaxAcknowledgedPredictionKeys + 1, false);
+	}
+
+	AcknowledgedPredictionKeys.Add(PredictionKey.Current);
+	MARK_PROPERTY_DIRTY_FROM_NAME(UInventoryComponent, AcknowledgedPredictionKeys, this);
+
+	// Owners such as player states update infrequently, and the client is waiting on this to settle its prediction
+	GetOwner()->ForceNetUpdate();
+}
+
+void UInventoryComponent::OnPredictionRejected(FPredictionKey::KeyType PredictionKey)
+{
+	ResolvePredictedOperations([PredictionKey](const FPredictedOperation& Operation)
 	{
-		return *Item.GetType() == *ItemType; 
+		return Operation.PredictionKey == PredictionKey;
 	});
 }
 
+void UInventoryComponent::OnPredictionCaughtUp(FPredictionKey::KeyType PredictionKey)
+{
+	UWorld* World = GetWorld();
+	if (!World || PredictionTimeout <= 0.f)
+	{
+		// Without a timeout, assume the server never applies changes it hasn't acknowledged by now
+		OnPredictionRejected(PredictionKey);
+		return;
+	}
 
+	// The key can catch up before the acknowledgement arrives, such as when the ability system belongs to another actor
+	bool bAnyCaughtUp = false;
+	for (FPredictedOperation& Operation : PredictedOperations)
+	{
+		if (Operation.PredictionKey == PredictionKey && Operation.CaughtUpTime < 0.f)
+		{
+			Operation.CaughtUpTime = World->GetTimeSeconds();
+			bAnyCaughtUp = true;
+		}
+	}
 
-// Delegate functions
+	if (bAnyCaughtUp && !World->GetTimerManager().IsTimerActive(PredictionTimeoutHandle))
+	{
+		World->GetTimerManager().SetTimer(PredictionTimeoutHandle, this, &UInventoryComponent::OnPredictionTimeout, PredictionTimeout, false);
+	}
+}
 
-void UInventoryComponent::OnInventoryArrayChanged()
+void UInventoryComponent::OnPredictionTimeout()
 {
-	OnInventoryChanged.Broadcast();
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	const float CurrentTime = World->GetTimeSeconds();
+
+	ResolvePredictedOperations([this, CurrentTime](const FPredictedOperation& Operation)
+	{
+		return Operation.CaughtUpTime >= 0.f && CurrentTime - Operation.CaughtUpTime >= PredictionTimeout - KINDA_SMALL_NUMBER;
+	});
+
+	// Wait for the next operation that caught up to time out
+	float NextTimeout = -1.f;
+	for (const FPredictedOperation& Operation : PredictedOperations)
+	{
+		if (Operation.CaughtUpTime >= 0.f)
+		{
+			const float TimeLeft = Operation.CaughtUpTime + PredictionTimeout - CurrentTime;
+			NextTimeout = NextTimeout < 0.f ? TimeLeft : FMath::Min(NextTimeout, TimeLeft);
+		}
+	}
+
+	if (NextTimeout > 0.f)
+	{
+		World->GetTimerManager().SetTimer(PredictionTimeoutHandle, this, &UInventoryComponent::OnPredictionTimeout, NextTimeout, false);
+	}
 }
 
 
@@ -272,3 +1029,40 @@ void UInventoryComponent::OnRep_InventoryArray()
 {
 	
 }
+
+void UInventoryComponent::OnRep_InventorySummary()
+{
+	OnSummaryChanged.Broadcast();
+}
+
+void UInventoryComponent::OnRep_PageSummaries()
+{
+	OnPageSummariesChanged.Broadcast();
+}
+
+void UInventoryComponent::OnRep_AcknowledgedPredictionKeys()
+{
+	// The item changes replicate along with the keys, so they have already replaced any stacks the server touched. Keys
+	// that aren't acknowledged yet may still be in flight, so only the listed ones are resolved
+	ResolvePredictedOperations([this](const FPredictedOperation& Operation)
+	{
+		return AcknowledgedPredictionKeys.Contains(Operation.PredictionKey);
+	});
+}
+
+void UInventoryComponent::ServerSubscribeToPages_Implementation(const TArray<int32>& Pages)
+{
+	if (Pages.Num() > FInventoryArray::MaxSubscribedPages)
+	{
+		// No display shows this many pages, so the request can't have come from a well behaved client
+		UE_LOG(LogInventorySystem, Warning, TEXT("%s ignored a subscription to %d pages"), *GetNameSafe(this), Pages.Num());
+		return;
+	}
+
+	InventoryArray.SetSubscribedPages(Pages);
+}
+
+void UInventoryComponent::ServerResyncItems_Implementation(const TArray<int32>& ReplicationIDs)
+{
+	InventoryArray.ResyncReplicatedItems(ReplicationIDs);
+}
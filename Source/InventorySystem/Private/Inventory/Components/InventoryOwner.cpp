@@ -14,3 +14,40 @@ IInventoryOwner::FAdditionResult IInventoryOwner::AddItem(const FInventoryItem&
 
 	return InventoryComponent->AddItem(NewItem);
 }
+
+IInventoryOwner::FAdditionResult IInventoryOwner::PredictAddItem(const FInventoryItem& NewItem, const FPredictionKey& PredictionKey)
+{
+	UInventoryComponent* InventoryComponent = GetInventoryComponent();
+	if (!InventoryComponent)
+	{
+		return FAdditionResult(0, FInventoryArrayHandle());
+	}
+
+	return InventoryComponent->PredictAddItem(NewItem, PredictionKey);
+}
+
+TArray<IInventoryOwner::FAdditionResult> IInventoryOwner::AddItems(TArrayView<const FInventoryItem> NewItems)
+{
+	UInventoryComponent* InventoryComponent = GetInventoryComponent();
+	if (!InventoryComponent)
+	{
+		TArray<FAdditionResult> Results;
+		Results.Init(FAdditionResult(0, FInventoryArrayHandle()), NewItems.Num());
+		return Results;
+	}
+
+	return InventoryComponent->AddItems(NewItems);
+}
+
+TArray<int32> IInventoryOwner::RemoveItems(TArrayView<const FRemovalRequest> ItemsToRemove)
+{
+	UInventoryComponent* InventoryComponent = GetInventoryComponent();
+	if (!InventoryComponent)
+	{
+		TArray<int32> Results;
+		Results.Init(0, ItemsToRemove.Num());
+		return Results;
+	}
+
+	return InventoryComponent->RemoveItems(ItemsToRemove);
+}
@@ -2,19 +2,102 @@
 
 #include "Inventory/DataTypes/ItemData.h"
 
-FInventoryItemDataBase* FInventoryItemDataBase::Copy() const
+
+namespace
+{
+	/**
+	 * Returns the number of 1 / Scale steps closest to a value, clamped to what fits in an int32
+	 */
+	int32 ToFixedPointSteps(const float Value, const int32 Scale)
+	{
+		const double ScaledValue = FMath::RoundHalfFromZero(static_cast<double>(Value) * Scale);
+		return static_cast<int32>(FMath::Clamp<double>(ScaledValue, MIN_int32, MAX_int32));
+	}
+}
+
+
+// FInventoryItemDataBase
+
+void FInventoryItemDataBase::NetSerializeForItem(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItemTypeTraits& TypeTraits,
+	bool& bOutSuccess)
 {
 	UScriptStruct* ScriptStruct = GetScriptStruct();
-	if (!ScriptStruct)
+	UScriptStruct::ICppStructOps* CppStructOps = ScriptStruct->GetCppStructOps();
+
+	if (CppStructOps->HasNetSerializer())
+	{
+		CppStructOps->NetSerialize(Ar, PackageMap, bOutSuccess, this);
+		return;
+	}
+
+	bOutSuccess = true;
+
+	for (TFieldIterator<FProperty> PropertyIt(ScriptStruct); PropertyIt; ++PropertyIt)
+	{
+		const FProperty* Property = *PropertyIt;
+
+		for (int32 ArrayIndex = 0; ArrayIndex < Property->ArrayDim; ArrayIndex++)
+		{
+			void* Value = Property->ContainerPtrToValuePtr<void>(this, ArrayIndex);
+
+			if (!NetSerializeProperty(Ar, PackageMap, Property, Value, TypeTraits))
+			{
+				bOutSuccess &= Property->NetSerializeItem(Ar, PackageMap, Value);
+			}
+		}
+	}
+}
+
+
+
+
+// FInventoryNetQuantization
+
+void FInventoryNetQuantization::SerializeBoundedInt(FArchive& Ar, int32& Value, const int32 MaxValue)
+{
+	uint8 bInRange = Ar.IsSaving() && MaxValue >= 0 && Value >= 0 && Value <= MaxValue;
+	Ar.SerializeBits(&bInRange, 1);
+
+	if (bInRange)
+	{
+		uint32 BoundedValue = static_cast<uint32>(Value);
+		Ar.SerializeInt(BoundedValue, static_cast<uint32>(MaxValue) + 1);
+
+		if (Ar.IsLoading())
+		{
+			Value = static_cast<int32>(BoundedValue);
+		}
+	}
+	else
+	{
+		SerializePackedInt(Ar, Value);
+	}
+}
+
+void FInventoryNetQuantization::SerializePackedInt(FArchive& Ar, int32& Value)
+{
+	// Zigzag encode so that small negative values stay small too
+	uint32 PackedValue = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	Ar.SerializeIntPacked(PackedValue);
+
+	if (Ar.IsLoading())
 	{
-		return nullptr;
+		Value = static_cast<int32>(PackedValue >> 1) ^ -static_cast<int32>(PackedValue & 1);
 	}
+}
 
-	// Allocate a new struct and copy data from this struct
-	FInventoryItemDataBase* NewData = static_cast<FInventoryItemDataBase*>(FMemory::Malloc(ScriptStruct->GetStructureSize()));
-	ScriptStruct->InitializeStruct(NewData);
-	ScriptStruct->CopyScriptStruct(NewData, this);
+void FInventoryNetQuantization::SerializeFixedPoint(FArchive& Ar, float& Value, const int32 Scale)
+{
+	int32 Steps = Ar.IsSaving() ? ToFixedPointSteps(Value, Scale) : 0;
+	SerializePackedInt(Ar, Steps);
 
-	return NewData;
+	if (Ar.IsLoading())
+	{
+		Value = static_cast<float>(static_cast<double>(Steps) / Scale);
+	}
 }
 
+float FInventoryNetQuantization::QuantizeFixedPoint(const float Value, const int32 Scale)
+{
+	return static_cast<float>(static_cast<double>(ToFixedPointSteps(Value, Scale)) / Scale);
+}
@@ -0,0 +1,249 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/DataTypes/ItemDataStorage.h"
+#include "Inventory/DataTypes/ItemData.h"
+
+
+// FInventoryItemDataStorage
+
+FInventoryItemDataStorage::FInventoryItemDataStorage(const FInventoryItemDataStorage& Other)
+{
+	CopyFrom(Other);
+}
+
+FInventoryItemDataStorage::FInventoryItemDataStorage(FInventoryItemDataStorage&& Other) noexcept
+{
+	MoveFrom(Other);
+}
+
+FInventoryItemDataStorage& FInventoryItemDataStorage::operator=(const FInventoryItemDataStorage& Other)
+{
+	if (this == &Other)
+	{
+		return *this;
+	}
+
+	if (ScriptStruct && ScriptStruct == Other.ScriptStruct)
+	{
+		if (!IsInline())
+		{
+			if (HeapBlock == Other.HeapBlock)
+			{
+				// Already sharing the same data
+				return *this;
+			}
+		}
+		else
+		{
+			// Copy over the existing inline data instead of reconstructing it when the types match
+			ScriptStruct->CopyScriptStruct(&InlineData, &Other.InlineData);
+			return *this;
+		}
+	}
+
+	Reset();
+	CopyFrom(Other);
+	return *this;
+}
+
+FInventoryItemDataStorage& FInventoryItemDataStorage::operator=(FInventoryItemDataStorage&& Other) noexcept
+{
+	if (this == &Other)
+	{
+		return *this;
+	}
+
+	Reset();
+	MoveFrom(Other);
+	return *this;
+}
+
+
+
+// Storage control
+
+void FInventoryItemDataStorage::Initialize(UScriptStruct* InScriptStruct)
+{
+	Reset();
+
+	if (!InScriptStruct)
+	{
+		return;
+	}
+
+	check(InScriptStruct->IsChildOf(FInventoryItemDataBase::StaticStruct()));
+
+	ScriptStruct = InScriptStruct;
+
+	if (IsInline())
+	{
+		ScriptStruct->InitializeStruct(&InlineData);
+	}
+	else
+	{
+		HeapBlock = AllocateHeapBlock(ScriptStruct);
+		ScriptStruct->InitializeStruct(HeapBlock + GetHeapDataOffset(ScriptStruct));
+	}
+}
+
+void FInventoryItemDataStorage::Reset()
+{
+	if (!ScriptStruct)
+	{
+		return;
+	}
+
+	if (IsInline())
+	{
+		ScriptStruct->DestroyStruct(&InlineData);
+	}
+	else
+	{
+		ReleaseHeapBlock(HeapBlock, ScriptStruct);
+		HeapBlock = nullptr;
+	}
+
+	ScriptStruct = nullptr;
+}
+
+
+
+// Accessors
+
+bool FInventoryItemDataStorage::IsShared() const
+{
+	if (!ScriptStruct || IsInline())
+	{
+		return false;
+	}
+
+	return GetHeapReferenceCount(HeapBlock).GetValue() > 1;
+}
+
+FInventoryItemDataBase* FInventoryItemDataStorage::GetMutable()
+{
+	if (!ScriptStruct)
+	{
+		return nullptr;
+	}
+
+	if (IsInline())
+	{
+		return reinterpret_cast<FInventoryItemDataBase*>(&InlineData);
+	}
+
+	if (IsShared())
+	{
+		// Detach from the other copies before handing out mutable data
+		uint8* SharedBlock = HeapBlock;
+		const int32 DataOffset = GetHeapDataOffset(ScriptStruct);
+
+		HeapBlock = AllocateHeapBlock(ScriptStruct);
+		ScriptStruct->InitializeStruct(HeapBlock + DataOffset);
+		ScriptStruct->CopyScriptStruct(HeapBlock + DataOffset, SharedBlock + DataOffset);
+
+		ReleaseHeapBlock(SharedBlock, ScriptStruct);
+	}
+
+	return reinterpret_cast<FInventoryItemDataBase*>(HeapBlock + GetHeapDataOffset(ScriptStruct));
+}
+
+bool FInventoryItemDataStorage::CanStoreInline(const UScriptStruct* InScriptStruct)
+{
+	check(InScriptStruct);
+
+	return InScriptStruct->GetStructureSize() <= InlineSize && InScriptStruct->GetMinAlignment() <= InlineAlignment;
+}
+
+
+
+// Helper functions
+
+const void* FInventoryItemDataStorage::GetMemory() const
+{
+	if (!ScriptStruct)
+	{
+		return nullptr;
+	}
+
+	if (IsInline())
+	{
+		return &InlineData;
+	}
+
+	return HeapBlock + GetHeapDataOffset(ScriptStruct);
+}
+
+void FInventoryItemDataStorage::CopyFrom(const FInventoryItemDataStorage& Other)
+{
+	check(!ScriptStruct);
+
+	if (!Other.ScriptStruct)
+	{
+		return;
+	}
+
+	if (Other.IsInline())
+	{
+		Initialize(Other.ScriptStruct);
+		ScriptStruct->CopyScriptStruct(&InlineData, &Other.InlineData);
+		return;
+	}
+
+	// Share heap data until one of the copies is mutated
+	ScriptStruct = Other.ScriptStruct;
+	HeapBlock = Other.HeapBlock;
+	GetHeapReferenceCount(HeapBlock).Increment();
+}
+
+void FInventoryItemDataStorage::MoveFrom(FInventoryItemDataStorage& Other)
+{
+	check(!ScriptStruct);
+
+	if (!Other.ScriptStruct)
+	{
+		return;
+	}
+
+	if (Other.IsInline())
+	{
+		// Inline data can't be stolen, and data structs aren't guaranteed to be trivially relocatable, so copy it and
+		// destroy the original
+		CopyFrom(Other);
+		Other.Reset();
+		return;
+	}
+
+	// Heap data can just change owners
+	ScriptStruct = Other.ScriptStruct;
+	HeapBlock = Other.HeapBlock;
+
+	Other.ScriptStruct = nullptr;
+	Other.HeapBlock = nullptr;
+}
+
+uint8* FInventoryItemDataStorage::AllocateHeapBlock(const UScriptStruct* InScriptStruct)
+{
+	const int32 Alignment = FMath::Max<int32>(InScriptStruct->GetMinAlignment(), alignof(FThreadSafeCounter));
+	uint8* Block = static_cast<uint8*>(FMemory::Malloc(GetHeapDataOffset(InScriptStruct) + InScriptStruct->GetStructureSize(), Alignment));
+
+	new (Block) FThreadSafeCounter(1);
+	return Block;
+}
+
+void FInventoryItemDataStorage::ReleaseHeapBlock(uint8* Block, const UScriptStruct* InScriptStruct)
+{
+	if (GetHeapReferenceCount(Block).Decrement() > 0)
+	{
+		return;
+	}
+
+	InScriptStruct->DestroyStruct(Block + GetHeapDataOffset(InScriptStruct));
+	GetHeapReferenceCount(Block).~FThreadSafeCounter();
+	FMemory::Free(Block);
+}
+
+int32 FInventoryItemDataStorage::GetHeapDataOffset(const UScriptStruct* InScriptStruct)
+{
+	return Align(static_cast<int32>(sizeof(FThreadSafeCounter)), InScriptStruct->GetMinAlignment());
+}
@@ -1,11 +1,31 @@
 ﻿// Copyright (c) 2020 Spencer Melnick
 
 #include "Inventory/DataTypes/StackData.h"
+#include "Inventory/ItemTypes/ItemTypeBase.h"
 
-bool FInventoryStackData::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
+void FInventoryStackData::NetSerializeForItem(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItemTypeTraits& TypeTraits,
+	bool& bOutSuccess)
 {
-	Ar << StackCount;
+	FInventoryNetQuantization::SerializeBoundedInt(Ar, StackCount, TypeTraits.MaxStackSize);
 	bOutSuccess = true;
+}
+
+bool FInventoryStackData::NetSerializeProperty(FArchive& Ar, UPackageMap* PackageMap, const FProperty* Property, void* Value,
+	const FInventoryItemTypeTraits& TypeTraits)
+{
+	if (Property->GetFName() != GET_MEMBER_NAME_CHECKED(FInventoryStackData, StackCount))
+	{
+		return false;
+	}
+
+	FInventoryNetQuantization::SerializeBoundedInt(Ar, *static_cast<int32*>(Value), TypeTraits.MaxStackSize);
 	return true;
 }
 
+bool FInventoryStackData::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
+{
+	// Without an item type there's no bound, but most stacks are small
+	FInventoryNetQuantization::SerializePackedInt(Ar, StackCount);
+	bOutSuccess = true;
+	return true;
+}
@@ -1,6 +1,7 @@
 ﻿// Copyright (c) 2020 Spencer Melnick
 
 #include "Inventory/InventoryArray.h"
+#include "Inventory/ItemTypes/ItemTypePool.h"
 
 
 
@@ -10,12 +11,25 @@
 
 int32 FInventoryArrayHandle::GetIndex() const
 {
+	// The token guarantees the array hasn't been destroyed since the index was cached, so it's safe to read the array
+	// revision without validating the owner
+	if (CachedIndex != INDEX_NONE && CachedToken.IsValid() && *CachedToken && CachedRevision == Array->Revision)
+	{
+		return CachedIndex;
+	}
+
 	if (IsNull())
 	{
+		CachedIndex = INDEX_NONE;
+		CachedToken.Reset();
 		return INDEX_NONE;
 	}
 
-	return Array->LookupIndex(ItemID);
+	CachedIndex = Array->LookupIndex(ItemID);
+	CachedRevision = Array->Revision;
+	CachedToken = Array->HandleToken.Flag;
+
+	return CachedIndex;
 }
 
 FInventoryItem* FInventoryArrayHandle::Get() const
@@ -27,8 +41,8 @@ FInventoryItem* FInventoryArrayHandle::Get() const
 		return nullptr;
 	}
 
-	check(Index < Array->Items.Num());
-	return &Array->Items[Index];
+	check(Array->IsValidItemIndex(Index));
+	return &Array->GetItemAt(Index);
 }
 
 void FInventoryArrayHandle::MarkDirty()
@@ -55,41 +69,100 @@ void FInventoryArrayHandle::Remove()
 
 // FInventoryArray
 
+FInventoryArray::FReplicationWriteContext* FInventoryArray::ActiveWriteContext = nullptr;
+FInventoryArray* FInventoryArray::ActiveReadArray = nullptr;
+
 void FInventoryArray::PostSerialize(FArchive& Ar)
 {
 	if (Ar.IsLoading())
 	{
-		// If we loaded from something, rebuild the ID map!
-		RebuildIDMap();
-		NotifyArrayChanged();
+		// If we loaded from something, none of the items have slots yet
+		RebuildSlots();
 	}
 }
 
 
 void FInventoryArray::PostReplicatedAdd(const TArrayView<int32>& AddedIndices, int32 FinalSize)
 {
+	for (const int32 AddedIndex : AddedIndices)
+	{
+		// Replicated items don't carry their IDs, so assign them local slots
+		const int32 ItemID = AllocateSlot(AddedIndex);
+
+		if (!Items[AddedIndex].IsValid())
+		{
+			// The item's first state couldn't be applied, so hold it back until the resent full state arrives
+			DeferredAddItemIDs.Add(ItemID);
+			continue;
+		}
+
+		NotifyItemAdded(ItemID);
+	}
+
 	if (AddedIndices.Num() > 0)
 	{
-		// If we received any additions, we need to rebuild the local ID map
-		bNeedsIDRebuild = true;
-		bReceivedChanges = true;
+		NotifyArrayChanged();
 	}
 }
 
 void FInventoryArray::PostReplicatedChange(const TArrayView<int32>& ChangedIndices, int32 FinalSize)
 {
+	for (const int32 ChangedIndex : ChangedIndices)
+	{
+		const int32 ItemID = Items[ChangedIndex].UniqueID;
+
+		if (DeferredAddItemIDs.Contains(ItemID))
+		{
+			if (!Items[ChangedIndex].IsValid())
+			{
+				continue;
+			}
+
+			// The full state of a held back item arrived, so it can finally be reported
+			DeferredAddItemIDs.Remove(ItemID);
+			UpdateIndices(ChangedIndex);
+			MarkSlotChanged(GetSlotIndex(ItemID));
+			UpdateAggregates(GetSlotIndex(ItemID));
+			NotifyItemAdded(ItemID);
+			continue;
+		}
+
+		// The replicated type or data may have changed the item's tags
+		UpdateIndices(ChangedIndex);
+		NotifyItemChanged(ItemID);
+	}
+
 	if (ChangedIndices.Num() > 0)
 	{
-		bReceivedChanges = true;
+		NotifyArrayChanged();
 	}
 }
 
 void FInventoryArray::PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize)
 {
+	for (const int32 RemovedIndex : RemovedIndices)
+	{
+		const int32 ItemID = Items[RemovedIndex].UniqueID;
+
+		if (DeferredAddItemIDs.Remove(ItemID) == 0)
+		{
+			// Held back items were never reported, so there is nothing to report for them now
+			NotifyItemRemoved(ItemID);
+		}
+
+		FreeSlot(ItemID);
+		SetReceivedItemTypeID(Items[RemovedIndex].ReplicationID, 0);
+		ReceivedItems.Remove(Items[RemovedIndex].ReplicationID);
+
+		// Dynamic types created by replication can be recycled once copies of the item are gone too
+		FInventoryItemTypePool::Get().Release(Items[RemovedIndex].Type);
+	}
+
 	if (RemovedIndices.Num() > 0)
 	{
-		bNeedsIDRebuild = true;
-		bReceivedChanges = true;
+		// The fast array swaps the last items into the removed indices after this, so track them for slot fixup
+		ReplicatedRemovedIndices.Append(RemovedIndices.GetData(), RemovedIndices.Num());
+		NotifyArrayChanged();
 	}
 }
 
@@ -97,23 +170,273 @@ void FInventoryArray::PreReplicatedRemove(const TArrayView<int32>& RemovedIndice
 
 bool FInventoryArray::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams)
 {
-	const bool Result = FastArrayDeltaSerialize(Items, DeltaParams, *this);
+	bool bResult;
 
-	if (bNeedsIDRebuild)
+	if (DeltaParams.Writer)
 	{
-		// If we added or deleted any elements, rebuild the ID map
-		RebuildIDMap();
-		bNeedsIDRebuild = false;
+		// Let changed items write themselves relative to what the connection received in the base state
+		FReplicationWriteContext WriteContext;
+		WriteContext.Array = this;
+		WriteContext.Baseline = FindReplicationBaseline(DeltaParams.OldState);
+
+		{
+			TGuardValue<FReplicationWriteContext*> WriteContextGuard(ActiveWriteContext, &WriteContext);
+			bResult = FastArrayDeltaSerialize(Items, DeltaParams, *this);
+		}
+
+		if (ResyncItemIDs.Num() > 0)
+		{
+			// Items the client asked for were just sent in full. If that update is lost too, the client asks again
+			for (const TPair<int32, FReplicationBaselineItem>& WrittenItem : WriteContext.WrittenItems)
+			{
+				ResyncItemIDs.Remove(WrittenItem.Key);
+			}
+		}
+
+		if (DeltaParams.NewState && DeltaParams.NewState->IsValid())
+		{
+			StoreReplicationBaseline(*DeltaParams.NewState, WriteContext);
+		}
+
+		if (StreamedPageCount < SubscribedPages.Num())
+		{
+			// Stream in the next pages - their items are marked dirty, so there's another update to write them
+			StreamedPageCount = FMath::Min(StreamedPageCount + PagesStreamedPerUpdate, SubscribedPages.Num());
+			UpdateStreamedPages();
+		}
+
+		return bResult;
 	}
 
-	if (bReceivedChanges)
 	{
-		// If anything was added, deleted, or changed, notify the delegates
-		NotifyArrayChanged();
-		bReceivedChanges = false;
+		// Hold any notifications from the replication callbacks until the slots are valid again
+		FScopedInventoryBatch Batch(*this);
+		TGuardValue<FInventoryArray*> ReadArrayGuard(ActiveReadArray, this);
+		bResult = FastArrayDeltaSerialize(Items, DeltaParams, *this);
+
+		for (const int32 RemovedIndex : ReplicatedRemovedIndices)
+		{
+			// Every item moved by a swap removal ends up in one of the removed indices
+			if (RemovedIndex < Items.Num())
+			{
+				Slots[GetSlotIndex(Items[RemovedIndex].UniqueID)].ItemIndex = RemovedIndex;
+			}
+		}
+
+		if (ReplicatedRemovedIndices.Num() > 0)
+		{
+			// Items were moved by the swap removals
+			Revision++;
+			ReplicatedRemovedIndices.Reset();
+		}
 	}
 
-	return Result;
+	if (PendingResyncRequests.Num() > 0)
+	{
+		ResyncRequestedDelegate.ExecuteIfBound();
+	}
+
+	return bResult;
+}
+
+const FInventoryItem* FInventoryArray::GetReplicationBaseline(const int32 ReplicationID, uint32& OutBaselineSerial)
+{
+	OutBaselineSerial = 0;
+
+	if (!ActiveWriteContext || !ActiveWriteContext->Baseline.IsValid() || ActiveWriteContext->Array->ResyncItemIDs.Contains(ReplicationID))
+	{
+		return nullptr;
+	}
+
+	const FReplicationBaselineItem* BaselineItem = ActiveWriteContext->Baseline->Items.Find(ReplicationID);
+	if (!BaselineItem)
+	{
+		return nullptr;
+	}
+
+	OutBaselineSerial = BaselineItem->Serial;
+	return &BaselineItem->Item;
+}
+
+bool FInventoryArray::ShouldReplicatePlaceholder(const FInventoryItem& Item, int32& OutPage)
+{
+	OutPage = INDEX_NONE;
+
+	if (!ActiveWriteContext || ActiveWriteContext->Array->PageSize <= 0)
+	{
+		return false;
+	}
+
+	const FInventoryArray& Array = *ActiveWriteContext->Array;
+	OutPage = GetSlotIndex(Item.UniqueID) / Array.PageSize;
+
+	return !Array.IsPageStreamed(OutPage);
+}
+
+uint32 FInventoryArray::RecordReplicatedItem(const FInventoryItem& Item)
+{
+	if (!ActiveWriteContext)
+	{
+		return 0;
+	}
+
+	FInventoryArray& Array = *ActiveWriteContext->Array;
+	if (Array.NextReplicationSerial == 0)
+	{
+		// Zero is reserved for items written outside of an inventory array
+		Array.NextReplicationSerial++;
+	}
+
+	// Copies share any heap allocated item data, so this is cheap for items that didn't change
+	FReplicationBaselineItem& WrittenItem = ActiveWriteContext->WrittenItems.Add(Item.ReplicationID);
+	WrittenItem.Item = Item;
+	WrittenItem.Serial = Array.NextReplicationSerial++;
+
+	return WrittenItem.Serial;
+}
+
+uint32 FInventoryArray::MapReplicatedTypeDefinition(const FInventoryItemTypeDefinition& Definition, const int32 ReplicationID, bool& bOutConnectionHasDefinition)
+{
+	bOutConnectionHasDefinition = false;
+
+	if (!ActiveWriteContext)
+	{
+		return 0;
+	}
+
+	FInventoryArray& Array = *ActiveWriteContext->Array;
+	uint32* ExistingID = Array.TypeDefinitionIDs.Find(Definition);
+	const uint32 TypeID = ExistingID ? *ExistingID : Array.TypeDefinitionIDs.Add(Definition, Array.NextTypeDefinitionID++);
+
+	// Items the client asked for were missing something, possibly the definition, so they always carry it
+	bOutConnectionHasDefinition = ActiveWriteContext->Baseline.IsValid() && ActiveWriteContext->Baseline->TypeIDs.Contains(TypeID)
+		&& !Array.ResyncItemIDs.Contains(ReplicationID);
+
+	// Either way, the item uses the definition once this update arrives
+	FReplicationBaselineItem* WrittenItem = ActiveWriteContext->WrittenItems.Find(ReplicationID);
+	if (WrittenItem)
+	{
+		WrittenItem->TypeID = TypeID;
+	}
+
+	return TypeID;
+}
+
+void FInventoryArray::StoreReceivedTypeDefinition(const uint32 TypeID, const FInventoryItemTypeDefinition& Definition)
+{
+	if (ActiveReadArray)
+	{
+		// Definitions can be resent when the server isn't sure we have them, so keep the count of items using it
+		ActiveReadArray->ReceivedTypeDefinitions.FindOrAdd(TypeID).Definition = Definition;
+	}
+}
+
+const FInventoryItemTypeDefinition* FInventoryArray::FindReceivedTypeDefinition(const uint32 TypeID)
+{
+	if (!ActiveReadArray)
+	{
+		return nullptr;
+	}
+
+	const FReceivedTypeDefinition* ReceivedDefinition = ActiveReadArray->ReceivedTypeDefinitions.Find(TypeID);
+	return ReceivedDefinition ? &ReceivedDefinition->Definition : nullptr;
+}
+
+void FInventoryArray::UseReceivedTypeDefinition(const int32 ReplicationID, const uint32 TypeID)
+{
+	if (ActiveReadArray)
+	{
+		ActiveReadArray->SetReceivedItemTypeID(ReplicationID, TypeID);
+	}
+}
+
+void FInventoryArray::UpdateReceivedTypeContribution(const int32 UniqueID)
+{
+	if (!ActiveReadArray || ActiveReadArray->LookupIndex(UniqueID) == INDEX_NONE)
+	{
+		// New items are contributed once they're given a slot
+		return;
+	}
+
+	// Snapshots capture the type traits as well
+	const int32 SlotIndex = GetSlotIndex(UniqueID);
+	ActiveReadArray->MarkSlotChanged(SlotIndex);
+	ActiveReadArray->UpdateAggregates(SlotIndex);
+}
+
+bool FInventoryArray::HasReceivedItemState(const int32 ReplicationID, const uint32 Serial)
+{
+	if (!ActiveReadArray)
+	{
+		return false;
+	}
+
+	const FReceivedItemState* ItemState = ActiveReadArray->ReceivedItems.Find(ReplicationID);
+	return ItemState && ItemState->Serial == Serial;
+}
+
+void FInventoryArray::StoreReceivedItemState(const int32 ReplicationID, const uint32 Serial)
+{
+	if (ActiveReadArray)
+	{
+		ActiveReadArray->ReceivedItems.FindOrAdd(ReplicationID).Serial = Serial;
+	}
+}
+
+void FInventoryArray::RequestReplicatedItemResync(const int32 ReplicationID)
+{
+	if (ActiveReadArray)
+	{
+		// Each item is read at most once per update, so there are no duplicates to worry about
+		ActiveReadArray->PendingResyncRequests.Add(ReplicationID);
+	}
+}
+
+
+
+// Resynchronization
+
+void FInventoryArray::ConsumeResyncRequests(TArray<int32>& OutReplicationIDs)
+{
+	// The server only handles so many at once, and the rest are sent after the next replication update
+	const int32 NumIDs = FMath::Min(PendingResyncRequests.Num(), MaxResyncRequests);
+	OutReplicationIDs.Reset(NumIDs);
+	OutReplicationIDs.Append(PendingResyncRequests.GetData(), NumIDs);
+	PendingResyncRequests.RemoveAt(0, NumIDs);
+}
+
+void FInventoryArray::ResyncReplicatedItems(const TArray<int32>& ReplicationIDs)
+{
+	// The IDs come from a client, so no more are handled than a client ever sends at once
+	const int32 NumIDs = FMath::Min(ReplicationIDs.Num(), MaxResyncRequests);
+
+	for (int32 IDIndex = 0; IDIndex < NumIDs; IDIndex++)
+	{
+		const int32 ReplicationID = ReplicationIDs[IDIndex];
+		const int32* SlotIndex = ReplicationIDSlots.Find(ReplicationID);
+		if (!SlotIndex)
+		{
+			// The item was removed since, which the client will hear about anyways
+			continue;
+		}
+
+		if (PageSize > 0 && !IsPageStreamed(*SlotIndex / PageSize))
+		{
+			// Only streamed pages are written in full, and the item is sent again once its page streams in
+			continue;
+		}
+
+		bool bAlreadyRequested = false;
+		ResyncItemIDs.Add(ReplicationID, &bAlreadyRequested);
+		if (bAlreadyRequested)
+		{
+			// The item is already waiting to be written in full
+			continue;
+		}
+
+		// Make sure the item is written again, without a baseline
+		MarkItemDirtyForReplication(GetItemAt(Slots[*SlotIndex].ItemIndex));
+	}
 }
 
 
@@ -133,7 +456,9 @@ void FInventoryArray::MarkDirty(FInventoryArrayHandle& ItemHandle)
 		return;
 	}
 
-	MarkItemDirty(*Item);
+	UpdateIndices(ItemHandle.GetIndex());
+	MarkItemDirtyDeferred(*Item);
+	NotifyItemChanged(Item->UniqueID);
 	NotifyArrayChanged();
 }
 
@@ -153,85 +478,1059 @@ void FInventoryArray::Remove(FInventoryArrayHandle& ItemHandle)
 	}
 
 	// Delete the item
-	check(Index < Items.Num());
-	Items.RemoveAt(Index);
+	check(IsValidItemIndex(Index));
+	RemoveAtSwapInternal(Index);
 	NotifyItemsDeleted();
 }
 
 void FInventoryArray::Empty(int32 Slack)
 {
+	for (const TArray<FInventoryItem>* ItemList : { &Items, &PredictedItems })
+	{
+		for (const FInventoryItem& Item : *ItemList)
+		{
+			NotifyItemRemoved(Item.UniqueID);
+			FreeSlot(Item.UniqueID);
+		}
+	}
+
 	Items.Empty(Slack);
-	IDtoIndex.Empty();
-	MarkArrayDirty();
+	PredictedItems.Empty();
+	Revision++;
+	MarkArrayDirtyDeferred();
 	NotifyArrayChanged();
 }
 
-TArray<FInventoryArrayHandle> FInventoryArray::GetArrayHandles()
+void FInventoryArray::ReplaceItems(TArray<FInventoryItem>&& NewItems)
 {
-	TArray<FInventoryArrayHandle> Result;
-	Result.Reserve(Items.Num());
+	FScopedInventoryBatch Batch(*this);
+	Empty();
 
-	for (FInventoryItem& Item : Items)
+	Items = MoveTemp(NewItems);
+
+	for (int32 Index = 0; Index < Items.Num(); Index++)
+	{
+		// Items may come from anywhere, so make sure they're replicated as new items
+		Items[Index].ReplicationID = INDEX_NONE;
+		Items[Index].ReplicationKey = INDEX_NONE;
+
+		NotifyItemAdded(AllocateSlot(Index));
+		MarkItemDirtyDeferred(Items[Index]);
+	}
+
+	NotifyArrayChanged();
+}
+
+TArray<FInventoryItem*> FInventoryArray::FindAllByTypeTemporary(const UInventoryItemTypeBase* ItemType)
+{
+	TArray<FInventoryItem*> Result;
+
+	const TArray<int32>* ItemIDs = FindIDsByType(ItemType);
+	if (!ItemIDs)
+	{
+		return Result;
+	}
+
+	Result.Reserve(ItemIDs->Num());
+	for (const int32 ItemID : *ItemIDs)
 	{
-		Result.Add(FInventoryArrayHandle(Item.UniqueID, Owner, this));
+		Result.Add(&GetItemAt(LookupIndex(ItemID)));
 	}
 
 	return Result;
 }
 
+TArray<FInventoryArrayHandle> FInventoryArray::FindAllByType(const UInventoryItemTypeBase* ItemType)
+{
+	TArray<FInventoryArrayHandle> Result;
+	FindAllByType(ItemType, Result);
+	return Result;
+}
 
+FInventoryItem* FInventoryArray::FindByTypeTemporary(const UInventoryItemTypeBase* ItemType)
+{
+	const TArray<int32>* ItemIDs = FindIDsByType(ItemType);
+	if (!ItemIDs)
+	{
+		return nullptr;
+	}
 
+	// Entries are removed from the index once they're empty, so there is always at least one item
+	return &GetItemAt(LookupIndex((*ItemIDs)[0]));
+}
 
-// State changes
+FInventoryArrayHandle FInventoryArray::FindByType(const UInventoryItemTypeBase* ItemType)
+{
+	const TArray<int32>* ItemIDs = FindIDsByType(ItemType);
+	if (!ItemIDs)
+	{
+		return FInventoryArrayHandle();
+	}
 
-void FInventoryArray::NotifyArrayChanged()
+	return FInventoryArrayHandle((*ItemIDs)[0], Owner, this);
+}
+
+TArray<FInventoryArrayHandle> FInventoryArray::FindAllByTagQuery(const FGameplayTagQuery& Query)
 {
-	InventoryArrayChangedDelegate.ExecuteIfBound();
+	return GetSlotHandles(TagIndex.Evaluate(Query));
 }
 
+TArray<FInventoryItem*> FInventoryArray::FindAllByTagQueryTemporary(const FGameplayTagQuery& Query)
+{
+	const FInventorySlotSet SlotSet = TagIndex.Evaluate(Query);
 
-void FInventoryArray::NotifyItemsDeleted()
+	TArray<FInventoryItem*> Result;
+	Result.Reserve(SlotSet.Num());
+
+	SlotSet.ForEach([this, &Result](const int32 SlotIndex)
+	{
+		Result.Add(&GetItemAt(Slots[SlotIndex].ItemIndex));
+	});
+
+	return Result;
+}
+
+TArray<FInventoryArrayHandle> FInventoryArray::FindAllByTag(const FGameplayTag& Tag)
 {
-	// Update the array state and notify any listeners
-	MarkArrayDirty();
-	bNeedsIDRebuild = true;
-	NotifyArrayChanged();
+	return GetSlotHandles(TagIndex.FindSlotsWithTag(Tag));
+}
+
+FInventoryArrayHandle FInventoryArray::GetHandle(const int32 UniqueID)
+{
+	if (LookupIndex(UniqueID) == INDEX_NONE)
+	{
+		return FInventoryArrayHandle();
+	}
+
+	return FInventoryArrayHandle(UniqueID, Owner, this);
+}
+
+FInventoryArrayHandle FInventoryArray::GetHandleByReplicationID(const int32 InReplicationID)
+{
+	if (InReplicationID == INDEX_NONE)
+	{
+		return FInventoryArrayHandle();
+	}
+
+	// The fast array's own map is emptied whenever the array is marked dirty, so the slots keep their own
+	const int32* SlotIndex = ReplicationIDSlots.Find(InReplicationID);
+	if (!SlotIndex)
+	{
+		return FInventoryArrayHandle();
+	}
+
+	// Slots are taken out of the map when they're freed, so a mapped slot always holds an item
+	return FInventoryArrayHandle(MakeItemID(*SlotIndex, Slots[*SlotIndex].Generation), Owner, this);
+}
+
+TArray<FInventoryArrayHandle> FInventoryArray::GetArrayHandles()
+{
+	TArray<FInventoryArrayHandle> Result;
+	GetArrayHandles(Result);
+	return Result;
 }
 
 
 
-// Helper functions
+// Visitors
 
-void FInventoryArray::RebuildIDMap()
+void FInventoryArray::ForEachHandle(TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor)
 {
-	for (int32 i = 0; i < Items.Num(); i++)
+	for (const TArray<FInventoryItem>* ItemList : { &Items, &PredictedItems })
 	{
-		if (Items[i].UniqueID == INDEX_NONE)
+		for (const FInventoryItem& Item : *ItemList)
 		{
-			// If an item doesn't have an ID yet, assign it one
-			Items[i].UniqueID = GetNextID();
+			if (!Visitor(FInventoryArrayHandle(Item.UniqueID, Owner, this)))
+			{
+				return;
+			}
 		}
-		
-		IDtoIndex.Emplace(Items[i].UniqueID, i);
 	}
 }
 
-int32 FInventoryArray::LookupIndex(const int32 UniqueID)
+void FInventoryArray::ForEachHandleByType(const UInventoryItemTypeBase* ItemType, TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor)
 {
-	if (bNeedsIDRebuild)
+	const TArray<int32>* ItemIDs = FindIDsByType(ItemType);
+	if (!ItemIDs)
 	{
-		// Rebuild the ID map if any operation marked it dirty
-		RebuildIDMap();
-		bNeedsIDRebuild = false;
+		return;
 	}
 
-	int32* FoundIndex = IDtoIndex.Find(UniqueID);
-
-	if (!FoundIndex)
+	for (const int32 ItemID : *ItemIDs)
 	{
-		return INDEX_NONE;
+		if (!Visitor(FInventoryArrayHandle(ItemID, Owner, this)))
+		{
+			return;
+		}
 	}
+}
 
-	return *FoundIndex;
+void FInventoryArray::ForEachHandleByTagQuery(const FGameplayTagQuery& Query, TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor)
+{
+	bool bVisiting = true;
+
+	TagIndex.Evaluate(Query).ForEach([this, &Visitor, &bVisiting](const int32 SlotIndex)
+	{
+		if (bVisiting)
+		{
+			bVisiting = Visitor(FInventoryArrayHandle(MakeItemID(SlotIndex, Slots[SlotIndex].Generation), Owner, this));
+		}
+	});
 }
 
+
+
+// Read snapshots
+
+TSharedRef<const FInventoryReadSnapshot, ESPMode::ThreadSafe> FInventoryArray::GetReadSnapshot()
+{
+	check(IsInGameThread());
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(Slots.Num(), FInventoryReadSnapshot::ChunkSize);
+
+	if (ReadSnapshot.IsValid() && ReadSnapshot->Chunks.Num() == NumChunks && DirtySnapshotChunks.Find(true) == INDEX_NONE)
+	{
+		// Nothing changed since the last snapshot
+		return ReadSnapshot.ToSharedRef();
+	}
+
+	TSharedRef<FInventoryReadSnapshot, ESPMode::ThreadSafe> NewSnapshot = MakeShared<FInventoryReadSnapshot, ESPMode::ThreadSafe>();
+	NewSnapshot->Chunks.Reserve(NumChunks);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+	{
+		if (ReadSnapshot.IsValid() && ReadSnapshot->Chunks.IsValidIndex(ChunkIndex) && !DirtySnapshotChunks[ChunkIndex])
+		{
+			// Share the chunks that didn't change
+			NewSnapshot->Chunks.Add(ReadSnapshot->Chunks[ChunkIndex]);
+			NewSnapshot->NumItems += ReadSnapshot->Chunks[ChunkIndex]->Items.Num();
+			continue;
+		}
+
+		TSharedRef<FInventoryReadSnapshot::FChunk, ESPMode::ThreadSafe> Chunk = MakeShared<FInventoryReadSnapshot::FChunk, ESPMode::ThreadSafe>();
+		const int32 EndSlot = FMath::Min((ChunkIndex + 1) * FInventoryReadSnapshot::ChunkSize, Slots.Num());
+
+		for (int32 SlotIndex = ChunkIndex * FInventoryReadSnapshot::ChunkSize; SlotIndex < EndSlot; SlotIndex++)
+		{
+			if (Slots[SlotIndex].ItemIndex != INDEX_NONE)
+			{
+				// Copies share their data with the live items until either is modified
+				Chunk->Items.Emplace(GetItemAt(Slots[SlotIndex].ItemIndex));
+			}
+		}
+
+		NewSnapshot->NumItems += Chunk->Items.Num();
+		NewSnapshot->Chunks.Add(Chunk);
+	}
+
+	ReadSnapshot = NewSnapshot;
+	DirtySnapshotChunks.Init(false, NumChunks);
+	return NewSnapshot;
+}
+
+void FInventoryArray::MarkSlotChanged(const int32 SlotIndex)
+{
+	MarkPageDirty(SlotIndex);
+
+	// Chunks past the end of the last snapshot are always built fresh
+	const int32 ChunkIndex = SlotIndex / FInventoryReadSnapshot::ChunkSize;
+	if (DirtySnapshotChunks.IsValidIndex(ChunkIndex))
+	{
+		DirtySnapshotChunks[ChunkIndex] = true;
+	}
+}
+
+
+
+// Pagination
+
+void FInventoryArray::SetReplicationPageSize(const int32 InPageSize)
+{
+	PageSize = FMath::Max(0, InPageSize);
+
+	// Subscriptions refer to the old page boundaries
+	SubscribedPages.Reset();
+	StreamedPageCount = 0;
+	StreamedPages.Empty();
+
+	// Every summary needs to be computed with the new page boundaries
+	DirtyPages.Init(true, GetNumPages());
+
+	for (FInventoryItem& Item : Items)
+	{
+		// Items switch between placeholders and their full state
+		MarkItemDirtyForReplication(Item);
+	}
+
+	MarkArrayDirtyForReplication();
+}
+
+int32 FInventoryArray::GetReplicationPage(const int32 ItemID) const
+{
+	const int32 Index = LookupIndex(ItemID);
+
+	if (PageSize <= 0 || Index == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 ReceivedPage = GetItemAt(Index).GetReplicationPage();
+	return ReceivedPage != INDEX_NONE ? ReceivedPage : GetSlotIndex(ItemID) / PageSize;
+}
+
+void FInventoryArray::SetSubscribedPages(const TArray<int32>& Pages)
+{
+	// Pages that are already streamed go first, so that they keep streaming and only the pages that came into view
+	// have to stream in
+	TArray<int32> NewSubscribedPages;
+	TArray<int32> NewPages;
+
+	// Pages may come from a client, so only pages that exist are kept, each one once, up to the subscription limit
+	const int32 NumPages = GetNumPages();
+	TBitArray<> SeenPages(false, NumPages);
+
+	for (const int32 Page : Pages)
+	{
+		if (Page < 0 || Page >= NumPages || SeenPages[Page])
+		{
+			continue;
+		}
+
+		SeenPages[Page] = true;
+		(IsPageStreamed(Page) ? NewSubscribedPages : NewPages).Add(Page);
+
+		if (NewSubscribedPages.Num() + NewPages.Num() >= MaxSubscribedPages)
+		{
+			break;
+		}
+	}
+
+	const int32 NumKeptPages = NewSubscribedPages.Num();
+
+	if (NewPages.Num() == 0 && NumKeptPages == StreamedPageCount && SubscribedPages.Num() == StreamedPageCount)
+	{
+		// Every streamed page is still subscribed, and nothing else is
+		return;
+	}
+
+	NewSubscribedPages.Append(NewPages);
+	SubscribedPages = MoveTemp(NewSubscribedPages);
+	StreamedPageCount = FMath::Min(NumKeptPages + PagesStreamedPerUpdate, SubscribedPages.Num());
+	UpdateStreamedPages();
+}
+
+void FInventoryArray::UpdateStreamedPages()
+{
+	const int32 NumPages = GetNumPages();
+	TBitArray<> NewStreamedPages(false, NumPages);
+
+	for (int32 PageIndex = 0; PageIndex < StreamedPageCount; PageIndex++)
+	{
+		// Subscribed pages were checked against the page count, which only grows
+		const int32 Page = SubscribedPages[PageIndex];
+		if (NewStreamedPages.IsValidIndex(Page))
+		{
+			NewStreamedPages[Page] = true;
+		}
+	}
+
+	for (int32 Page = 0; Page < NumPages; Page++)
+	{
+		const bool bWasStreamed = IsPageStreamed(Page);
+		const bool bIsStreamed = NewStreamedPages.IsValidIndex(Page) && NewStreamedPages[Page];
+
+		if (bWasStreamed == bIsStreamed)
+		{
+			continue;
+		}
+
+		// Items in the page switch between placeholders and their full state
+		const int32 EndSlot = FMath::Min((Page + 1) * PageSize, Slots.Num());
+
+		for (int32 SlotIndex = Page * PageSize; SlotIndex < EndSlot; SlotIndex++)
+		{
+			if (Slots[SlotIndex].ItemIndex != INDEX_NONE && !IsPredictedIndex(Slots[SlotIndex].ItemIndex))
+			{
+				MarkItemDirtyForReplication(Items[Slots[SlotIndex].ItemIndex]);
+			}
+		}
+	}
+
+	StreamedPages = MoveTemp(NewStreamedPages);
+}
+
+bool FInventoryArray::UpdatePageSummaries(TArray<FInventoryPageSummary>& Summaries)
+{
+	const int32 NumPages = GetNumPages();
+	bool bChanged = Summaries.Num() != NumPages;
+	Summaries.SetNum(NumPages);
+
+	for (TConstSetBitIterator<> PageIt(DirtyPages); PageIt; ++PageIt)
+	{
+		const int32 Page = PageIt.GetIndex();
+
+		if (Page >= NumPages)
+		{
+			break;
+		}
+
+		FInventoryPageSummary NewSummary;
+		const int32 EndSlot = FMath::Min((Page + 1) * PageSize, Slots.Num());
+
+		for (int32 SlotIndex = Page * PageSize; SlotIndex < EndSlot; SlotIndex++)
+		{
+			if (Slots[SlotIndex].ItemIndex == INDEX_NONE)
+			{
+				continue;
+			}
+
+			// Summing the item hashes keeps the checksum independent of the item order
+			const FInventoryItem& Item = GetItemAt(Slots[SlotIndex].ItemIndex);
+			const uint32 TypeHash = Item.GetType() ? Item.GetType()->GetItemTypeHash() : 0;
+			NewSummary.ItemCount++;
+			NewSummary.Checksum += HashCombine(TypeHash, GetTypeHash(Item.GetStackCount()));
+		}
+
+		if (NewSummary != Summaries[Page])
+		{
+			Summaries[Page] = NewSummary;
+			bChanged = true;
+		}
+	}
+
+	DirtyPages.Init(false, DirtyPages.Num());
+	return bChanged;
+}
+
+void FInventoryArray::MarkPageDirty(const int32 SlotIndex)
+{
+	if (PageSize <= 0)
+	{
+		return;
+	}
+
+	const int32 Page = SlotIndex / PageSize;
+
+	while (DirtyPages.Num() <= Page)
+	{
+		DirtyPages.Add(false);
+	}
+
+	DirtyPages[Page] = true;
+}
+
+
+
+// Batching
+
+void FInventoryArray::EndBatch()
+{
+	check(BatchDepth > 0);
+
+	if (--BatchDepth > 0)
+	{
+		// Only the outermost batch flushes
+		return;
+	}
+
+	for (const int32 ItemID : BatchDirtyItemIDs)
+	{
+		// Items removed later in the batch no longer need to be marked
+		const int32 Index = LookupIndex(ItemID);
+		if (Index != INDEX_NONE)
+		{
+			MarkItemDirtyForReplication(GetItemAt(Index));
+		}
+	}
+	BatchDirtyItemIDs.Reset();
+
+	if (bBatchArrayDirty)
+	{
+		bBatchArrayDirty = false;
+		MarkArrayDirtyForReplication();
+	}
+
+	// Move the pending events out first, in case a listener modifies the array
+	const TSet<int32> AddedItemIDs = MoveTemp(BatchAddedItemIDs);
+	const TSet<int32> ChangedItemIDs = MoveTemp(BatchChangedItemIDs);
+	BatchAddedItemIDs.Reset();
+	BatchChangedItemIDs.Reset();
+
+	for (const int32 ItemID : AddedItemIDs)
+	{
+		ItemAddedDelegate.Broadcast(ItemID);
+	}
+
+	for (const int32 ItemID : ChangedItemIDs)
+	{
+		ItemChangedDelegate.Broadcast(ItemID);
+	}
+
+	if (bBatchChanged)
+	{
+		bBatchChanged = false;
+		NotifyArrayChanged();
+	}
+}
+
+
+
+
+// State changes
+
+void FInventoryArray::NotifyArrayChanged()
+{
+	if (IsBatching())
+	{
+		bBatchChanged = true;
+		return;
+	}
+
+	InventoryArrayChangedDelegate.ExecuteIfBound();
+}
+
+
+void FInventoryArray::NotifyItemsDeleted()
+{
+	// Update the array state and notify any listeners
+	MarkArrayDirtyDeferred();
+	NotifyArrayChanged();
+}
+
+void FInventoryArray::NotifyItemAdded(const int32 ItemID)
+{
+	if (IsBatching())
+	{
+		BatchAddedItemIDs.Add(ItemID);
+		return;
+	}
+
+	ItemAddedDelegate.Broadcast(ItemID);
+}
+
+void FInventoryArray::NotifyItemChanged(const int32 ItemID)
+{
+	MarkSlotChanged(GetSlotIndex(ItemID));
+	UpdateAggregates(GetSlotIndex(ItemID));
+
+	if (IsBatching())
+	{
+		// Listeners will see the final state of new items anyways
+		if (!BatchAddedItemIDs.Contains(ItemID))
+		{
+			BatchChangedItemIDs.Add(ItemID);
+		}
+		return;
+	}
+
+	ItemChangedDelegate.Broadcast(ItemID);
+}
+
+void FInventoryArray::NotifyItemRemoved(const int32 ItemID)
+{
+	if (IsBatching())
+	{
+		BatchChangedItemIDs.Remove(ItemID);
+
+		if (BatchAddedItemIDs.Remove(ItemID) > 0)
+		{
+			// Nobody was told about this item yet, so there is nothing to report
+			return;
+		}
+	}
+
+	// Removals are always reported immediately so that listeners can still access the item
+	ItemRemovedDelegate.Broadcast(ItemID);
+}
+
+void FInventoryArray::MarkItemDirtyDeferred(FInventoryItem& Item)
+{
+	if (IsBatching())
+	{
+		BatchDirtyItemIDs.Add(Item.UniqueID);
+		return;
+	}
+
+	MarkItemDirtyForReplication(Item);
+}
+
+void FInventoryArray::MarkArrayDirtyDeferred()
+{
+	if (IsBatching())
+	{
+		bBatchArrayDirty = true;
+		return;
+	}
+
+	MarkArrayDirtyForReplication();
+}
+
+void FInventoryArray::MarkItemDirtyForReplication(FInventoryItem& Item)
+{
+	if (bPredictingChanges || IsPredictedIndex(LookupIndex(Item.UniqueID)))
+	{
+		// Predicted changes are never sent, and marking the client's array dirty would only reset the replication map
+		return;
+	}
+
+	MarkItemDirty(Item);
+	ReplicationDirtyDelegate.ExecuteIfBound();
+
+	// Items are given their replication ID the first time they're marked dirty
+	UpdateReplicationIDSlot(GetSlotIndex(Item.UniqueID));
+}
+
+void FInventoryArray::MarkArrayDirtyForReplication()
+{
+	if (bPredictingChanges)
+	{
+		return;
+	}
+
+	MarkArrayDirty();
+	ReplicationDirtyDelegate.ExecuteIfBound();
+}
+
+
+
+// Slot management
+
+int32 FInventoryArray::AllocateSlot(const int32 ItemIndex)
+{
+	int32 SlotIndex;
+
+	if (FreeSlots.Num() > 0)
+	{
+		SlotIndex = FreeSlots.Pop(false);
+	}
+	else
+	{
+		checkf(Slots.Num() <= SlotIndexMask, TEXT("Inventory array slots exceeded limits - may God have mercy on our souls"));
+		SlotIndex = Slots.AddDefaulted();
+	}
+
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	Slot.ItemIndex = ItemIndex;
+	MarkSlotChanged(SlotIndex);
+	UpdateAggregates(SlotIndex);
+
+	const int32 UniqueID = MakeItemID(SlotIndex, Slot.Generation);
+	GetItemAt(ItemIndex).UniqueID = UniqueID;
+	AddToIndices(SlotIndex);
+	UpdateReplicationIDSlot(SlotIndex);
+
+	return UniqueID;
+}
+
+void FInventoryArray::FreeSlot(const int32 UniqueID)
+{
+	if (UniqueID == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 SlotIndex = GetSlotIndex(UniqueID);
+	if (!Slots.IsValidIndex(SlotIndex) || Slots[SlotIndex].Generation != GetSlotGeneration(UniqueID))
+	{
+		return;
+	}
+
+	RemoveFromIndices(SlotIndex);
+	MarkSlotChanged(SlotIndex);
+
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	if (Slot.ReplicationID != INDEX_NONE)
+	{
+		ReplicationIDSlots.Remove(Slot.ReplicationID);
+		Slot.ReplicationID = INDEX_NONE;
+	}
+
+	Slot.ItemIndex = INDEX_NONE;
+	UpdateAggregates(SlotIndex);
+
+	if (Slot.Generation < MaxSlotGeneration)
+	{
+		// Only reuse the slot if the new generation is still unique, otherwise retire it
+		Slot.Generation++;
+		FreeSlots.Add(SlotIndex);
+	}
+}
+
+void FInventoryArray::RebuildSlots()
+{
+	// The items the indices referred to are gone, so start the indices over
+	TypeIndex.Reset();
+	TagIndex.Reset();
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); SlotIndex++)
+	{
+		Slots[SlotIndex].IndexedType = nullptr;
+		Slots[SlotIndex].IndexedTypeHash = 0;
+		Slots[SlotIndex].TypeEntryID = FSetElementId();
+
+		if (Slots[SlotIndex].ItemIndex != INDEX_NONE)
+		{
+			// Free any slot still in use so that handles from before the rebuild are invalidated
+			FreeSlot(MakeItemID(SlotIndex, Slots[SlotIndex].Generation));
+		}
+	}
+
+	for (int32 Index = 0; Index < Items.Num(); Index++)
+	{
+		AllocateSlot(Index);
+	}
+
+	for (int32 Index = 0; Index < PredictedItems.Num(); Index++)
+	{
+		AllocateSlot(Index | PredictedIndexFlag);
+	}
+
+	Revision++;
+
+	// Every ID changed at once, so listeners rebuild whatever they keyed by ID instead of getting per item events
+	ItemIDsReassignedDelegate.ExecuteIfBound();
+	NotifyArrayChanged();
+}
+
+void FInventoryArray::RemoveAtSwapInternal(const int32 Index)
+{
+	const bool bPredicted = IsPredictedIndex(Index);
+	TArray<FInventoryItem>& ItemList = bPredicted ? PredictedItems : Items;
+	const int32 ListIndex = Index & ~PredictedIndexFlag;
+
+	NotifyItemRemoved(ItemList[ListIndex].UniqueID);
+	FreeSlot(ItemList[ListIndex].UniqueID);
+	ItemList.RemoveAtSwap(ListIndex, 1, false);
+
+	if (ListIndex < ItemList.Num())
+	{
+		// The last item was moved into the removed item's place, so point its slot to the new index
+		Slots[GetSlotIndex(ItemList[ListIndex].UniqueID)].ItemIndex = bPredicted ? ListIndex | PredictedIndexFlag : ListIndex;
+	}
+
+	Revision++;
+}
+
+void FInventoryArray::UpdateAggregates(const int32 SlotIndex)
+{
+	if (!Slots.IsValidIndex(SlotIndex))
+	{
+		return;
+	}
+
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	FInventoryAggregates NewContribution;
+
+	if (IsValidItemIndex(Slot.ItemIndex) && GetItemAt(Slot.ItemIndex).IsValid())
+	{
+		const FInventoryItem& Item = GetItemAt(Slot.ItemIndex);
+		const FInventoryItemTypeTraits& Traits = Item.GetType()->GetTypeTraits();
+		const int32 Count = Traits.bAllowsStacking ? Item.GetStackCount() : 1;
+
+		NewContribution.Weight = static_cast<double>(Traits.UnitWeight) * Count;
+		NewContribution.Value = static_cast<double>(Traits.UnitValue) * Count;
+		NewContribution.Slots = Traits.SlotCost;
+	}
+
+	Aggregates -= Slot.Contribution;
+	Aggregates += NewContribution;
+	Slot.Contribution = NewContribution;
+}
+
+void FInventoryArray::UpdateReplicationIDSlot(const int32 SlotIndex)
+{
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	const int32 ReplicationID = IsValidItemIndex(Slot.ItemIndex) ? GetItemAt(Slot.ItemIndex).ReplicationID : INDEX_NONE;
+
+	if (Slot.ReplicationID == ReplicationID)
+	{
+		return;
+	}
+
+	if (Slot.ReplicationID != INDEX_NONE)
+	{
+		ReplicationIDSlots.Remove(Slot.ReplicationID);
+	}
+
+	Slot.ReplicationID = ReplicationID;
+
+	if (ReplicationID != INDEX_NONE)
+	{
+		ReplicationIDSlots.Add(ReplicationID, SlotIndex);
+	}
+}
+
+int32 FInventoryArray::LookupIndex(const int32 UniqueID) const
+{
+	if (UniqueID == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 SlotIndex = GetSlotIndex(UniqueID);
+	if (!Slots.IsValidIndex(SlotIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	const FInventoryArraySlot& Slot = Slots[SlotIndex];
+	if (Slot.Generation != GetSlotGeneration(UniqueID))
+	{
+		// The item was removed and the slot may have been reused
+		return INDEX_NONE;
+	}
+
+	return Slot.ItemIndex;
+}
+
+
+
+// Lookup indices
+
+void FInventoryArray::AddToIndices(const int32 SlotIndex)
+{
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	const FInventoryItem& Item = GetItemAt(Slot.ItemIndex);
+	const FInventoryTypeIndexKey Key(Item.Type);
+	Slot.IndexedType = Item.Type;
+	Slot.IndexedTypeHash = Key.Hash;
+	Slot.TypeEntryID = FSetElementId();
+
+	if (!Item.Type)
+	{
+		// Items without a type can't be found by type or tag anyways
+		return;
+	}
+
+	// Tags are only gathered here, so filtering by tag never needs to query the item types
+	TagIndex.AddSlot(SlotIndex, Item.GetGameplayTags());
+
+	FSetElementId EntryID = TypeIndex.FindId(Key);
+	if (!EntryID.IsValidId())
+	{
+		FInventoryTypeIndexEntry NewEntry;
+		NewEntry.Type = Item.Type;
+		NewEntry.TypeHash = Key.Hash;
+		EntryID = TypeIndex.Add(MoveTemp(NewEntry));
+	}
+
+	// Element IDs stay valid until the entry itself is removed, so the slot can find its entry without the type
+	TypeIndex[EntryID].ItemIDs.Add(Item.UniqueID);
+	Slot.TypeEntryID = EntryID;
+}
+
+void FInventoryArray::RemoveFromIndices(const int32 SlotIndex)
+{
+	FInventoryArraySlot& Slot = Slots[SlotIndex];
+	const TWeakObjectPtr<const UInventoryItemTypeBase> IndexedType = Slot.IndexedType;
+	const FSetElementId EntryID = Slot.TypeEntryID;
+	Slot.IndexedType = nullptr;
+	Slot.IndexedTypeHash = 0;
+	Slot.TypeEntryID = FSetElementId();
+
+	if (!EntryID.IsValidId())
+	{
+		return;
+	}
+
+	TagIndex.RemoveSlot(SlotIndex);
+
+	FInventoryTypeIndexEntry& Entry = TypeIndex[EntryID];
+	Entry.ItemIDs.RemoveSingleSwap(MakeItemID(SlotIndex, Slot.Generation), false);
+
+	if (Entry.ItemIDs.Num() == 0)
+	{
+		TypeIndex.Remove(EntryID);
+	}
+	else if (Entry.Type == IndexedType || !Entry.Type.IsValid())
+	{
+		// The entry key belonged to this item, so key it with the type of a remaining item (the remaining items were
+		// filed with the same hash, so the entry doesn't need to move)
+		Entry.Type = GetItemAt(LookupIndex(Entry.ItemIDs[0])).Type;
+	}
+}
+
+void FInventoryArray::UpdateIndices(const int32 ItemIndex)
+{
+	if (!IsValidItemIndex(ItemIndex))
+	{
+		return;
+	}
+
+	const FInventoryItem& Item = GetItemAt(ItemIndex);
+	const int32 SlotIndex = GetSlotIndex(Item.UniqueID);
+	if (!Slots.IsValidIndex(SlotIndex))
+	{
+		return;
+	}
+
+	// Types can be changed in place, so compare the hash as well as the object
+	const UInventoryItemTypeBase* Type = Item.Type;
+	const FInventoryArraySlot& Slot = Slots[SlotIndex];
+	if (Slot.IndexedType.Get() == Type && Slot.IndexedTypeHash == (Type ? Type->GetItemTypeHash() : 0))
+	{
+		if (Slot.TypeEntryID.IsValidId())
+		{
+			// Tags can depend on the item data, so they have to be gathered again even if the type is the same
+			TagIndex.UpdateSlot(SlotIndex, Item.GetGameplayTags());
+		}
+
+		return;
+	}
+
+	RemoveFromIndices(SlotIndex);
+	AddToIndices(SlotIndex);
+}
+
+const TArray<int32>* FInventoryArray::FindIDsByType(const UInventoryItemTypeBase* ItemType) const
+{
+	if (!ItemType)
+	{
+		return nullptr;
+	}
+
+	const FInventoryTypeIndexEntry* Entry = TypeIndex.Find(FInventoryTypeIndexKey(ItemType));
+	if (!Entry)
+	{
+		return nullptr;
+	}
+
+	return &Entry->ItemIDs;
+}
+
+TArray<FInventoryArrayHandle> FInventoryArray::GetSlotHandles(const FInventorySlotSet& SlotSet)
+{
+	TArray<FInventoryArrayHandle> Result;
+	Result.Reserve(SlotSet.Num());
+
+	SlotSet.ForEach([this, &Result](const int32 SlotIndex)
+	{
+		Result.Add(FInventoryArrayHandle(MakeItemID(SlotIndex, Slots[SlotIndex].Generation), Owner, this));
+	});
+
+	return Result;
+}
+
+
+
+// Replication baselines
+
+TSharedPtr<const FInventoryArray::FReplicationBaseline> FInventoryArray::FindReplicationBaseline(const INetDeltaBaseState* BaseState) const
+{
+	if (!BaseState)
+	{
+		return nullptr;
+	}
+
+	const FReplicationBaselineEntry* Entry = ReplicationBaselines.Find(BaseState);
+
+	// The pointer alone isn't enough, since a released base state's address can be reused by a new one
+	if (!Entry || Entry->BaseState.Pin().Get() != BaseState)
+	{
+		return nullptr;
+	}
+
+	return Entry->Baseline;
+}
+
+void FInventoryArray::StoreReplicationBaseline(const TSharedPtr<INetDeltaBaseState>& BaseState, const FReplicationWriteContext& Context)
+{
+	// Drop the baselines of any base states the replication system has released
+	for (auto EntryIt = ReplicationBaselines.CreateIterator(); EntryIt; ++EntryIt)
+	{
+		if (!EntryIt.Value().BaseState.IsValid())
+		{
+			EntryIt.RemoveCurrent();
+		}
+	}
+
+	FReplicationBaselineEntry& Entry = ReplicationBaselines.Add(BaseState.Get());
+	Entry.BaseState = BaseState;
+
+	if (Context.WrittenItems.Num() == 0 && Context.Baseline.IsValid())
+	{
+		// Nothing was written, so the connection still has the same item states. Replication IDs are never reused, so
+		// stale entries for removed items are harmless
+		Entry.Baseline = Context.Baseline;
+		return;
+	}
+
+	TSharedRef<FReplicationBaseline> NewBaseline = MakeShared<FReplicationBaseline>();
+	NewBaseline->Items.Reserve(Items.Num());
+
+	for (const FInventoryItem& Item : Items)
+	{
+		// Written items take their new state, and the rest keep the state the connection was last sent
+		const FReplicationBaselineItem* BaselineItem = Context.WrittenItems.Find(Item.ReplicationID);
+
+		if (!BaselineItem && Context.Baseline.IsValid())
+		{
+			BaselineItem = Context.Baseline->Items.Find(Item.ReplicationID);
+		}
+
+		if (BaselineItem)
+		{
+			NewBaseline->Items.Add(Item.ReplicationID, *BaselineItem);
+
+			if (BaselineItem->TypeID != 0)
+			{
+				NewBaseline->TypeIDs.Add(BaselineItem->TypeID);
+			}
+		}
+	}
+
+	Entry.Baseline = NewBaseline;
+
+	if (TypeDefinitionIDs.Num() > TypeDefinitionPruneThreshold)
+	{
+		PruneTypeDefinitions();
+	}
+}
+
+void FInventoryArray::PruneTypeDefinitions()
+{
+	TSet<uint32> UsedTypeIDs;
+
+	for (const TPair<const INetDeltaBaseState*, FReplicationBaselineEntry>& BaselineEntry : ReplicationBaselines)
+	{
+		if (BaselineEntry.Value.Baseline.IsValid())
+		{
+			UsedTypeIDs.Append(BaselineEntry.Value.Baseline->TypeIDs);
+		}
+	}
+
+	for (auto DefinitionIt = TypeDefinitionIDs.CreateIterator(); DefinitionIt; ++DefinitionIt)
+	{
+		if (!UsedTypeIDs.Contains(DefinitionIt.Value()))
+		{
+			DefinitionIt.RemoveCurrent();
+		}
+	}
+
+	// Only prune again once the dictionary has doubled, so pruning stays cheap when most definitions are in use
+	TypeDefinitionPruneThreshold = FMath::Max(64, TypeDefinitionIDs.Num() * 2);
+}
+
+void FInventoryArray::SetReceivedItemTypeID(const int32 ReplicationID, const uint32 TypeID)
+{
+	FReceivedItemState* ItemState = TypeID != 0 ? &ReceivedItems.FindOrAdd(ReplicationID) : ReceivedItems.Find(ReplicationID);
+	if (!ItemState || ItemState->TypeID == TypeID)
+	{
+		return;
+	}
+
+	FReceivedTypeDefinition* NewDefinition = ReceivedTypeDefinitions.Find(TypeID);
+	if (NewDefinition)
+	{
+		NewDefinition->NumItems++;
+	}
+
+	FReceivedTypeDefinition* OldDefinition = ReceivedTypeDefinitions.Find(ItemState->TypeID);
+	if (OldDefinition && --OldDefinition->NumItems <= 0)
+	{
+		// The server only refers to definitions that one of our items was sent with, so nothing will ask for it again
+		ReceivedTypeDefinitions.Remove(ItemState->TypeID);
+	}
+
+	ItemState->TypeID = TypeID;
+}
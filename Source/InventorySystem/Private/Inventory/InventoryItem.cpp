@@ -3,7 +3,83 @@
 #include "Inventory/InventoryItem.h"
 #include "InventorySystem.h"
 #include "Inventory/ItemTypes/ItemTypeBase.h"
+#include "Inventory/ItemTypes/StackItemType.h"
+#include "Inventory/ItemTypes/ItemTypePool.h"
 #include "Inventory/DataTypes/ItemData.h"
+#include "Inventory/DataTypes/StackData.h"
+#include "Inventory/InventoryArray.h"
+
+
+
+namespace
+{
+	// Upper bound on the size of a length prefixed payload, so corrupt packets are rejected before allocating anything
+	constexpr uint32 MaxNetPayloadBits = 1 << 16;
+
+	/**
+	 * Writes the contents of a bit writer, prefixed with the number of bits
+	 */
+	void WriteNetPayload(FArchive& Ar, FNetBitWriter& Payload)
+	{
+		uint32 NumBits = Payload.GetNumBits();
+		Ar.SerializeIntPacked(NumBits);
+		Ar.SerializeBits(Payload.GetData(), NumBits);
+	}
+
+	/**
+	 * Reads a payload written by WriteNetPayload
+	 * @return False if the payload length is invalid, in which case the archive is set to an error state
+	 */
+	bool ReadNetPayload(FArchive& Ar, TArray<uint8>& OutBytes, uint32& OutNumBits)
+	{
+		OutNumBits = 0;
+		Ar.SerializeIntPacked(OutNumBits);
+
+		if (OutNumBits > MaxNetPayloadBits)
+		{
+			UE_LOG(LogInventorySystem, Error, TEXT("FInventoryItem::NetSerialize failed - payload of %u bits is too large"), OutNumBits)
+			Ar.SetError();
+			return false;
+		}
+
+		OutBytes.SetNumZeroed((OutNumBits + 7) >> 3);
+		Ar.SerializeBits(OutBytes.GetData(), OutNumBits);
+		return true;
+	}
+
+	/**
+	 * Serializes a changed bit for each property of the item data, followed by the value of the property if it changed.
+	 * When saving, properties are compared against the baseline data, which is ignored when loading
+	 */
+	void NetSerializeChangedProperties(FArchive& Ar, UPackageMap* PackageMap, FInventoryItemDataBase* ItemData,
+		const FInventoryItemDataBase* BaselineData, const FInventoryItemTypeTraits& TypeTraits, bool& bOutSuccess)
+	{
+		for (TFieldIterator<FProperty> PropertyIt(ItemData->GetScriptStruct()); PropertyIt; ++PropertyIt)
+		{
+			const FProperty* Property = *PropertyIt;
+
+			for (int32 ArrayIndex = 0; ArrayIndex < Property->ArrayDim; ArrayIndex++)
+			{
+				void* Value = Property->ContainerPtrToValuePtr<void>(ItemData, ArrayIndex);
+				uint8 bChanged = 0;
+
+				if (Ar.IsSaving())
+				{
+					bChanged = !Property->Identical(Value, Property->ContainerPtrToValuePtr<void>(BaselineData, ArrayIndex));
+				}
+
+				Ar.SerializeBits(&bChanged, 1);
+
+				// Let the data pack the property using the item type's limits if it wants to
+				if (bChanged && !ItemData->NetSerializeProperty(Ar, PackageMap, Property, Value, TypeTraits))
+				{
+					bOutSuccess &= Property->NetSerializeItem(Ar, PackageMap, Value);
+				}
+			}
+		}
+	}
+}
+
 
 
 // FInventoryItem
@@ -17,7 +93,7 @@ FText FInventoryItem::GetName() const
 		return FText();
 	}
 
-	return Type->GetItemName(Data);
+	return Type->GetItemName(Data.Get());
 }
 
 FText FInventoryItem::GetDescription() const
@@ -27,7 +103,7 @@ FText FInventoryItem::GetDescription() const
 		return FText();
 	}
 
-	return Type->GetItemDescription(Data);
+	return Type->GetItemDescription(Data.Get());
 }
 
 TSoftClassPtr<APreviewActor> FInventoryItem::GetPreviewActorClass() const
@@ -37,7 +113,7 @@ TSoftClassPtr<APreviewActor> FInventoryItem::GetPreviewActorClass() const
 		return nullptr;
 	}
 
-	return Type->GetPreviewActorClass(Data);
+	return Type->GetPreviewActorClass(Data.Get());
 }
 
 TSoftObjectPtr<UTexture2D> FInventoryItem::GetThumbnailImage() const
@@ -47,7 +123,7 @@ TSoftObjectPtr<UTexture2D> FInventoryItem::GetThumbnailImage() const
 		return nullptr;
 	}
 
-	return Type->GetThumbnailImage(Data);
+	return Type->GetThumbnailImage(Data.Get());
 }
 
 FGameplayTagContainer FInventoryItem::GetGameplayTags() const
@@ -57,7 +133,7 @@ FGameplayTagContainer FInventoryItem::GetGameplayTags() const
 		return FGameplayTagContainer::EmptyContainer;
 	}
 
-	return Type->GetGameplayTags(Data);
+	return Type->GetGameplayTags(Data.Get());
 }
 
 
@@ -69,7 +145,7 @@ bool FInventoryItem::AllowsDuplicates() const
 		return false;
 	}
 
-	return Type->AllowsDuplicates();
+	return Type->GetTypeTraits().bAllowsDuplicates;
 }
 
 bool FInventoryItem::AllowsStacking() const
@@ -79,7 +155,7 @@ bool FInventoryItem::AllowsStacking() const
 		return false;
 	}
 
-	return Type->AllowsStacking();
+	return Type->GetTypeTraits().bAllowsStacking;
 }
 
 int32 FInventoryItem::AddToStack(const int32 Count)
@@ -89,7 +165,14 @@ int32 FInventoryItem::AddToStack(const int32 Count)
 		return 0;
 	}
 
-	return Type->AddToStack(Data, Count);
+	const FInventoryItemTypeTraits& Traits = Type->GetTypeTraits();
+	if (Traits.bDirectStackData)
+	{
+		// Standard stacks can be modified directly, skipping the item type
+		return FStackItemTypeImplementation::AddToStack(GetDataAs<FInventoryStackData>()->StackCount, Count, Traits.MaxStackSize);
+	}
+
+	return Type->AddToStack(Data.GetMutable(), Count);
 }
 
 int32 FInventoryItem::RemoveFromStack(const int32 Count)
@@ -99,17 +182,30 @@ int32 FInventoryItem::RemoveFromStack(const int32 Count)
 		return 0;
 	}
 
-	return Type->RemoveFromStack(Data, Count);
+	const FInventoryItemTypeTraits& Traits = Type->GetTypeTraits();
+	if (Traits.bDirectStackData)
+	{
+		// Standard stacks can be modified directly, skipping the item type
+		return FStackItemTypeImplementation::RemoveFromStack(GetDataAs<FInventoryStackData>()->StackCount, Count);
+	}
+
+	return Type->RemoveFromStack(Data.GetMutable(), Count);
 }
 
-void FInventoryItem::SetStackCount(const int32 Count) const
+void FInventoryItem::SetStackCount(const int32 Count)
 {
 	if (!IsValid() || !AllowsStacking())
 	{
 		return;
 	}
 
-	Type->SetStackCount(Data, Count);
+	if (Type->GetTypeTraits().bDirectStackData)
+	{
+		GetDataAs<FInventoryStackData>()->StackCount = Count;
+		return;
+	}
+
+	Type->SetStackCount(Data.GetMutable(), Count);
 }
 
 
@@ -120,7 +216,12 @@ int32 FInventoryItem::GetStackCount() const
 		return 0;
 	}
 
-	return Type->GetStackCount(Data);
+	if (Type->GetTypeTraits().bDirectStackData)
+	{
+		return GetDataAs<FInventoryStackData>()->StackCount;
+	}
+
+	return Type->GetStackCount(Data.Get());
 }
 
 bool FInventoryItem::IsValid() const
@@ -130,10 +231,12 @@ bool FInventoryItem::IsValid() const
 		return false;
 	}
 
-	if (Type->GetItemDataType())
+	const UScriptStruct* ExpectedDataType = Type->GetTypeTraits().DataType;
+
+	if (ExpectedDataType)
 	{
 		// Make sure our data type matches the expected type
-		return Data.IsValid() && Type->GetItemDataType() == Data->GetScriptStruct();
+		return ExpectedDataType == Data.GetScriptStruct();
 	}
 
 	// If we have require no data, then the item should be valid
@@ -152,7 +255,7 @@ void FInventoryItem::SetType(UInventoryItemTypeBase* NewType)
 		return;
 	}
 	
-	Type = NewType;
+	AssignType(NewType);
 
 	if (!Type || !Type->GetItemDataType())
 	{
@@ -163,9 +266,9 @@ void FInventoryItem::SetType(UInventoryItemTypeBase* NewType)
 
 	UScriptStruct* NewItemDataType = Type->GetItemDataType();
 
-	if (!Data.IsValid() || NewItemDataType != Data->GetScriptStruct())
+	if (NewItemDataType != Data.GetScriptStruct())
 	{
-		Data = Type->CreateItemData();
+		Data.Initialize(NewItemDataType);
 	}
 }
 
@@ -176,9 +279,9 @@ void FInventoryItem::SetType(UInventoryItemTypeBase* NewType)
 
 bool FInventoryItem::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
 {
-	bool bStaticItemType;
-	TCheckedObjPtr<UInventoryItemTypeBase> SerializedItemType;
-	TSubclassOf<UInventoryItemTypeBase> SerializedItemTypeClass;
+	// Page numbers are offset by one, so that items outside of paginated arrays only take a single bit
+	uint32 PageNumber = 0;
+	uint8 bPlaceholderState = 0;
 
 	if (Ar.IsSaving())
 	{
@@ -189,110 +292,356 @@ bool FInventoryItem::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& b
 			return true;
 		}
 
-		bStaticItemType = Type->IsSupportedForNetworking();
+		int32 Page = INDEX_NONE;
+		bPlaceholderState = FInventoryArray::ShouldReplicatePlaceholder(*this, Page);
+		PageNumber = static_cast<uint32>(Page + 1);
+	}
+
+	Ar.SerializeIntPacked(PageNumber);
 
-		if (bStaticItemType)
+	if (PageNumber != 0)
+	{
+		Ar.SerializeBits(&bPlaceholderState, 1);
+	}
+
+	if (Ar.IsLoading())
+	{
+		ReplicationPage = static_cast<int32>(PageNumber) - 1;
+		bPlaceholder = bPlaceholderState != 0;
+	}
+
+	if (Ar.IsSaving() && bPlaceholderState)
+	{
+		// Write a copy holding only what the placeholder keeps, so the recorded baseline is exactly what the client has
+		FInventoryItem Placeholder = MakePlaceholder();
+		return Placeholder.NetSerializeState(Ar, PackageMap, bOutSuccess);
+	}
+
+	return NetSerializeState(Ar, PackageMap, bOutSuccess);
+}
+
+bool FInventoryItem::NetSerializeState(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
+{
+	const FInventoryItem* Baseline = nullptr;
+	uint32 Serial = 0;
+	uint32 BaselineSerial = 0;
+
+	if (Ar.IsSaving())
+	{
+		// Items written as part of an inventory array update have a baseline if the connection was already sent them
+		Baseline = FInventoryArray::GetReplicationBaseline(ReplicationID, BaselineSerial);
+
+		// Remember what the connection is about to receive, so the next update can be written relative to it
+		Serial = FInventoryArray::RecordReplicatedItem(*this);
+	}
+
+	// States written by an inventory array are numbered, so the receiver knows which state it has
+	Ar.SerializeIntPacked(Serial);
+
+	uint8 bDeltaEncoded = Baseline && CanNetSerializeDelta(*Baseline);
+	Ar.SerializeBits(&bDeltaEncoded, 1);
+
+	bool bApplied;
+
+	if (bDeltaEncoded)
+	{
+		Ar.SerializeIntPacked(BaselineSerial);
+		bApplied = NetSerializeDelta(Ar, PackageMap, Baseline, BaselineSerial, bOutSuccess);
+	}
+	else
+	{
+		bApplied = NetSerializeFull(Ar, PackageMap, bOutSuccess);
+	}
+
+	if (Ar.IsLoading() && Serial != 0)
+	{
+		if (bApplied)
 		{
-			// If our type is supported for networking, just replicate the object reference itself
-			SerializedItemType = Type;
+			FInventoryArray::StoreReceivedItemState(ReplicationID, Serial);
 		}
 		else
 		{
-			// Otherwise serialize the type class so we can create a new object
-			SerializedItemTypeClass = Type->GetClass();
+			// The packet this state depends on was lost, and the sender has no way of knowing, so ask for the item
+			FInventoryArray::RequestReplicatedItemResync(ReplicationID);
 		}
 	}
 
+	return true;
+}
+
+FInventoryItem FInventoryItem::MakePlaceholder() const
+{
+	FInventoryItem Placeholder(Type);
+	Placeholder.SetStackCount(GetStackCount());
+	Placeholder.ReplicationID = ReplicationID;
+	Placeholder.UniqueID = UniqueID;
+	Placeholder.bPlaceholder = true;
+
+	return Placeholder;
+}
+
+bool FInventoryItem::NetSerializeFull(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
+{
+	uint8 bStaticItemType = 0;
+
+	if (Ar.IsSaving())
+	{
+		bStaticItemType = Type->IsSupportedForNetworking();
+	}
+
 	// Serialize whether or not our item type is static
-	Ar << bStaticItemType;
+	Ar.SerializeBits(&bStaticItemType, 1);
+
+	bool bTypeReferenceOnly = false;
+	bool bTypeResolved = true;
 
 	if (bStaticItemType)
 	{
-		// Serialize the object reference if it's static
+		// If our type is supported for networking, just replicate the object reference itself
+		TCheckedObjPtr<UInventoryItemTypeBase> SerializedItemType = Type;
 		Ar << SerializedItemType;
+
+		if (Ar.IsLoading())
+		{
+			SetType(SerializedItemType.Get());
+
+			// The item no longer needs whatever type definition it had before
+			FInventoryArray::UseReceivedTypeDefinition(ReplicationID, 0);
+		}
 	}
 	else
 	{
-		// Serialize the object class if it's not
-		Ar << SerializedItemTypeClass;
+		// Otherwise replicate the type's state, so the receiver can keep its own copy
+		bTypeResolved = NetSerializeDynamicType(Ar, PackageMap, bTypeReferenceOnly, bOutSuccess);
+	}
+
+	if (!bTypeReferenceOnly)
+	{
+		if (Type && Data.IsValid())
+		{
+			// Serialize data based on our item data type - saving doesn't modify the data, so avoid detaching it from
+			// any copies that share it
+			FInventoryItemDataBase* ItemData = Ar.IsSaving() ? const_cast<FInventoryItemDataBase*>(Data.Get()) : Data.GetMutable();
+			ItemData->NetSerializeForItem(Ar, PackageMap, Type->GetTypeTraits(), bOutSuccess);
+		}
+
+		return bTypeResolved;
 	}
 
+	// A receiver that doesn't have the referenced type definition can't know how to read the data, so it's prefixed
+	// with its length to let the receiver skip it and ask for the definition
 	if (Ar.IsSaving())
 	{
-		if (!bStaticItemType)
+		FNetBitWriter DataWriter(PackageMap, 64);
+
+		if (Data.IsValid())
 		{
-			// If our type is mutable, have it serialize whatever additional data it needs
-			Type->NetSerialize(Ar, PackageMap, bOutSuccess);
+			const_cast<FInventoryItemDataBase*>(Data.Get())->NetSerializeForItem(DataWriter, PackageMap, Type->GetTypeTraits(), bOutSuccess);
 		}
 
-		UScriptStruct* ItemDataType = Type->GetItemDataType();
+		WriteNetPayload(Ar, DataWriter);
+	}
+	else if (Ar.IsLoading())
+	{
+		TArray<uint8> DataBytes;
+		uint32 DataBits;
 
-		if (ItemDataType)
+		if (!ReadNetPayload(Ar, DataBytes, DataBits))
 		{
-			check(ItemDataType->GetCppStructOps()->HasNetSerializer());
+			bOutSuccess = false;
+			return false;
+		}
 
-			// Serialize data based on our item data type
-			ItemDataType->GetCppStructOps()->NetSerialize(Ar, PackageMap, bOutSuccess, Data.Get());
+		if (bTypeResolved && Type && Data.IsValid() && DataBits > 0)
+		{
+			FNetBitReader DataReader(PackageMap, DataBytes.GetData(), DataBits);
+			Data.GetMutable()->NetSerializeForItem(DataReader, PackageMap, Type->GetTypeTraits(), bOutSuccess);
 		}
 	}
-	else if (Ar.IsLoading())
+
+	return bTypeResolved;
+}
+
+bool FInventoryItem::NetSerializeDynamicType(FArchive& Ar, UPackageMap* PackageMap, bool& bOutReferenceOnly, bool& bOutSuccess)
+{
+	FInventoryItemTypeDefinition Definition;
+	uint32 TypeID = 0;
+	uint8 bReferenceOnly = 0;
+
+	if (Ar.IsSaving())
 	{
-		if (!bStaticItemType)
+		// Capture the type's state by having it serialize whatever additional data it needs
+		FNetBitWriter DefinitionWriter(PackageMap, 64);
+		Type->NetSerialize(DefinitionWriter, PackageMap, bOutSuccess);
+
+		Definition.TypeClass = Type->GetClass();
+		Definition.NumBits = DefinitionWriter.GetNumBits();
+		Definition.Data = TArray<uint8>(DefinitionWriter.GetData(), (Definition.NumBits + 7) >> 3);
+
+		// The data is packed using the type traits, so make sure they match what the receiver will rebuild
+		Type->RefreshTypeTraits();
+
+		// Items replicated as part of an inventory array can refer to a definition the connection already received
+		bool bConnectionHasDefinition = false;
+		TypeID = FInventoryArray::MapReplicatedTypeDefinition(Definition, ReplicationID, bConnectionHasDefinition);
+		bReferenceOnly = bConnectionHasDefinition;
+	}
+
+	Ar.SerializeIntPacked(TypeID);
+
+	if (TypeID != 0)
+	{
+		Ar.SerializeBits(&bReferenceOnly, 1);
+	}
+
+	bOutReferenceOnly = bReferenceOnly != 0;
+
+	if (!bReferenceOnly)
+	{
+		TSubclassOf<UInventoryItemTypeBase> SerializedItemTypeClass = Definition.TypeClass;
+		Ar << SerializedItemTypeClass;
+
+		if (Ar.IsSaving())
 		{
-			// Default to null if we don't have a type class
-			TSubclassOf<UInventoryItemTypeBase> CurrentItemTypeClass = nullptr;
+			uint32 NumBits = Definition.NumBits;
+			Ar.SerializeIntPacked(NumBits);
+			Ar.SerializeBits(Definition.Data.GetData(), NumBits);
+		}
+		else if (Ar.IsLoading())
+		{
+			uint32 NumBits;
 
-			if (Type)
+			if (!ReadNetPayload(Ar, Definition.Data, NumBits))
 			{
-				// Get the current type class if we have one
-				CurrentItemTypeClass = Type->GetClass(); 
+				bOutSuccess = false;
+				return false;
 			}
-			
-			if (SerializedItemTypeClass != CurrentItemTypeClass)
-			{
-				// Create a new type object if it's different than our current type
 
-				UInventoryItemTypeBase* NewItemType = nullptr;
-				
-				if (SerializedItemTypeClass)
-				{
-					// Create a new object if the type is non-null (fall back to an empty object if it is)
-					NewItemType = NewObject<UInventoryItemTypeBase>(static_cast<UObject*>(GetTransientPackage()), SerializedItemTypeClass);
-				}
-				
-				SetType(NewItemType);
-			}
+			Definition.TypeClass = SerializedItemTypeClass;
+			Definition.NumBits = NumBits;
 
-			// Deserialize the mutable type data
-			if (Type)
+			if (TypeID != 0)
 			{
-				Type->NetSerialize(Ar, PackageMap, bOutSuccess);
+				FInventoryArray::StoreReceivedTypeDefinition(TypeID, Definition);
 			}
 		}
-		else
+	}
+
+	if (!Ar.IsLoading())
+	{
+		return true;
+	}
+
+	const FInventoryItemTypeDefinition* ResolvedDefinition = bReferenceOnly
+		? FInventoryArray::FindReceivedTypeDefinition(TypeID)
+		: &Definition;
+
+	if (!ResolvedDefinition)
+	{
+		// The packet with the definition was lost or hasn't arrived yet - the caller asks the sender for the item in full
+		return false;
+	}
+
+	ApplyTypeDefinition(*ResolvedDefinition, PackageMap, bOutSuccess);
+
+	if (TypeID != 0)
+	{
+		FInventoryArray::UseReceivedTypeDefinition(ReplicationID, TypeID);
+	}
+
+	return true;
+}
+
+void FInventoryItem::ApplyTypeDefinition(const FInventoryItemTypeDefinition& Definition, UPackageMap* PackageMap, bool& bOutSuccess)
+{
+	UInventoryItemTypeBase* PreviousType = Type;
+
+	if (!Definition.TypeClass)
+	{
+		SetType(nullptr);
+	}
+	else if (!Type || Type->GetClass() != Definition.TypeClass || !Type->IsExclusivelyReferenced())
+	{
+		// Reuse a pooled type object instead of creating a new one if we can. A type shared with copies of this item is
+		// replaced instead of changed in place, so the copies keep the type they were made with
+		SetType(FInventoryItemTypePool::Get().Acquire(Definition.TypeClass));
+	}
+
+	if (PreviousType != Type)
+	{
+		FInventoryItemTypePool::Get().Release(PreviousType);
+	}
+
+	if (Type)
+	{
+		// Deserialize the mutable type data
+		FNetBitReader DefinitionReader(PackageMap, const_cast<uint8*>(Definition.Data.GetData()), Definition.NumBits);
+		Type->NetSerialize(DefinitionReader, PackageMap, bOutSuccess);
+		Type->RefreshTypeTraits();
+	}
+
+	// The traits may have changed without the type object changing, so the owning array's totals need to be updated
+	FInventoryArray::UpdateReceivedTypeContribution(UniqueID);
+}
+
+bool FInventoryItem::NetSerializeDelta(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItem* Baseline, const uint32 BaselineSerial, bool& bOutSuccess)
+{
+	// The delta is prefixed with its length, so that a receiver missing the baseline (because the packet that carried it
+	// was lost or is still in flight) can skip over it and ask for a full update instead
+	if (Ar.IsSaving())
+	{
+		FNetBitWriter DeltaWriter(PackageMap, 64);
+
+		if (Data.IsValid())
 		{
-			SetType(SerializedItemType.Get());
+			NetSerializeChangedProperties(DeltaWriter, PackageMap, const_cast<FInventoryItemDataBase*>(Data.Get()),
+				Baseline->Data.Get(), Type->GetTypeTraits(), bOutSuccess);
 		}
 
-		UScriptStruct* ItemDataType = nullptr;
+		WriteNetPayload(Ar, DeltaWriter);
+	}
+	else if (Ar.IsLoading())
+	{
+		TArray<uint8> DeltaBytes;
+		uint32 DeltaBits;
 
-		if (Type)
+		if (!ReadNetPayload(Ar, DeltaBytes, DeltaBits))
 		{
-			ItemDataType = Type->GetItemDataType();
+			bOutSuccess = false;
+			return false;
 		}
 
-		if (ItemDataType)
+		UScriptStruct* ItemDataType = Data.GetScriptStruct();
+
+		if (!FInventoryArray::HasReceivedItemState(ReplicationID, BaselineSerial)
+			|| !Type || !Type->IsSupportedForNetworking() || Type->GetItemDataType() != ItemDataType)
 		{
-			check(ItemDataType->GetCppStructOps()->HasNetSerializer());
-			
-			// Serialize data based on our type if it's not null
-			ItemDataType->GetCppStructOps()->NetSerialize(Ar, PackageMap, bOutSuccess, Data.Get());
+			// We don't have the baseline this delta was written against
+			return false;
+		}
+
+		if (ItemDataType && DeltaBits > 0)
+		{
+			FNetBitReader DeltaReader(PackageMap, DeltaBytes.GetData(), DeltaBits);
+			NetSerializeChangedProperties(DeltaReader, PackageMap, Data.GetMutable(), nullptr, Type->GetTypeTraits(), bOutSuccess);
+
+			if (DeltaReader.IsError())
+			{
+				bOutSuccess = false;
+			}
 		}
 	}
 
 	return true;
 }
 
+bool FInventoryItem::CanNetSerializeDelta(const FInventoryItem& Baseline) const
+{
+	// Mutable types are owned by the item and can change without the pointer changing, so they're always sent in full
+	return Type && Baseline.Type == Type && Type->IsSupportedForNetworking()
+		&& Baseline.Data.GetScriptStruct() == Data.GetScriptStruct();
+}
+
 bool FInventoryItem::Serialize(FArchive& Ar)
 {
 	TCheckedObjPtr<UInventoryItemTypeBase> ItemType;
@@ -329,8 +678,9 @@ bool FInventoryItem::Serialize(FArchive& Ar)
 		// If our expected data type isn't null, our data should be valid
 		check(Data.IsValid());
 		
-		// Serialize the item data
-		Type->GetItemDataType()->SerializeItem(Ar, Data.Get(), nullptr);
+		// Serialize the item data, only detaching shared data if we're about to overwrite it
+		void* ItemData = Ar.IsLoading() ? Data.GetMutable() : const_cast<FInventoryItemDataBase*>(Data.Get());
+		Type->GetItemDataType()->SerializeItem(Ar, ItemData, nullptr);
 	}
 
 	return true;
@@ -0,0 +1,76 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/InventoryItemReference.h"
+#include "Inventory/InventoryItem.h"
+#include "Inventory/InventoryArray.h"
+#include "Inventory/Components/InventoryComponent.h"
+#include "Inventory/DataTypes/ItemData.h"
+#include "Inventory/ItemTypes/ItemTypeBase.h"
+
+
+
+// FInventoryItemNetReference
+
+FInventoryItemNetReference::FInventoryItemNetReference(const FInventoryArrayHandle& ItemHandle, const int32 InCount)
+	: Count(InCount)
+{
+	const FInventoryItem* Item = ItemHandle.Get();
+	if (!Item || !Item->IsValid())
+	{
+		return;
+	}
+
+	ReplicationID = Item->ReplicationID;
+
+	// Dynamic types can only be sent as part of an item, so they are only found through the replicated item
+	if (Item->GetType()->IsSupportedForNetworking())
+	{
+		Type = Item->GetType();
+	}
+}
+
+bool FInventoryItemNetReference::Resolve(UInventoryComponent* InventoryComponent, FInventoryItem& OutItem) const
+{
+	const FInventoryItem* Item = InventoryComponent ? InventoryComponent->GetItemByReplicationID(ReplicationID).Get() : nullptr;
+
+	if (Item && Item->IsValid())
+	{
+		OutItem = *Item;
+	}
+	else if (Type)
+	{
+		OutItem = FInventoryItem(Type);
+	}
+	else
+	{
+		return false;
+	}
+
+	if (OutItem.AllowsStacking())
+	{
+		OutItem.SetStackCount(Count);
+	}
+
+	return true;
+}
+
+bool FInventoryItemNetReference::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	uint8 bHasType = Type != nullptr;
+	Ar.SerializeBits(&bHasType, 1);
+
+	if (bHasType)
+	{
+		// Replicates as the type's network GUID, like the type of an inventory item
+		TCheckedObjPtr<UInventoryItemTypeBase> SerializedItemType = Type;
+		Ar << SerializedItemType;
+		Type = SerializedItemType.Get();
+	}
+
+	FInventoryNetQuantization::SerializePackedInt(Ar, ReplicationID);
+	FInventoryNetQuantization::SerializePackedInt(Ar, Count);
+
+	return true;
+}
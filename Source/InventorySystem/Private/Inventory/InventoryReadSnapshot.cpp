@@ -0,0 +1,62 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/InventoryReadSnapshot.h"
+#include "Inventory/InventoryArray.h"
+
+
+
+// FInventoryReadSnapshot::FItem
+
+FInventoryReadSnapshot::FItem::FItem(const FInventoryItem& Item) :
+	UniqueID(Item.UniqueID), TypeKey(Item.Type), StackCount(Item.GetStackCount()), bValid(Item.IsValid()), Data(Item.Data)
+{
+	check(IsInGameThread());
+
+	if (Item.Type)
+	{
+		TypeTraits = Item.Type->GetTypeTraits();
+	}
+}
+
+
+
+// FInventoryReadSnapshot
+
+void FInventoryReadSnapshot::ForEachItem(TFunctionRef<bool(const FItem&)> Visitor) const
+{
+	for (const FChunkRef& Chunk : Chunks)
+	{
+		for (const FItem& Item : Chunk->Items)
+		{
+			if (!Visitor(Item))
+			{
+				return;
+			}
+		}
+	}
+}
+
+const FInventoryReadSnapshot::FItem* FInventoryReadSnapshot::FindItem(const int32 UniqueID) const
+{
+	if (UniqueID == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const int32 ChunkIndex = FInventoryArray::GetSlotIndex(UniqueID) / ChunkSize;
+	if (!Chunks.IsValidIndex(ChunkIndex))
+	{
+		return nullptr;
+	}
+
+	// Chunks are small, so a scan is cheaper than keeping a lookup table in every chunk
+	for (const FItem& Item : Chunks[ChunkIndex]->Items)
+	{
+		if (Item.GetUniqueID() == UniqueID)
+		{
+			return &Item;
+		}
+	}
+
+	return nullptr;
+}
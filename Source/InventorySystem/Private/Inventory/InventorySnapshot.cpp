@@ -0,0 +1,639 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/InventorySnapshot.h"
+#include "InventorySystem.h"
+#include "Inventory/ItemTypes/ItemTypePool.h"
+#include "Engine/AssetManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+
+
+namespace
+{
+	/**
+	 * Fixed layout fields are copied as raw memory, so only numbers, enums, native bools, and structs made of them are
+	 * allowed. Plain old data isn't enough, since names are plain old data but index a table that differs between runs
+	 */
+	bool IsFixedLayoutProperty(const FProperty* Property)
+	{
+		if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			return BoolProperty->IsNativeBool();
+		}
+
+		if (Property->IsA<FNumericProperty>() || Property->IsA<FEnumProperty>())
+		{
+			return true;
+		}
+
+		if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			for (TFieldIterator<FProperty> PropertyIt(StructProperty->Struct); PropertyIt; ++PropertyIt)
+			{
+				if (!IsFixedLayoutProperty(*PropertyIt))
+				{
+					return false;
+				}
+			}
+
+			// The whole struct is copied, including any native members that aren't properties
+			return Property->HasAnyPropertyFlags(CPF_IsPlainOldData);
+		}
+
+		return false;
+	}
+
+	/**
+	 * Reads a table count, rejecting counts that couldn't possibly fit in the rest of the data
+	 */
+	bool ReadCount(FArchive& Ar, int32& OutCount)
+	{
+		uint32 Count = 0;
+		Ar.SerializeIntPacked(Count);
+
+		if (Ar.IsError() || Count > static_cast<uint32>(Ar.TotalSize() - Ar.Tell()))
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		OutCount = static_cast<int32>(Count);
+		return true;
+	}
+}
+
+
+
+// FInventorySnapshot
+
+// Writing
+
+void FInventorySnapshot::Write(TArrayView<const FInventoryItem> Items, TArray<uint8>& OutData)
+{
+	FWriter(Items).Write(OutData);
+}
+
+
+
+// Reading
+
+bool FInventorySnapshot::Read(TArray<uint8>&& InData)
+{
+	Data = MoveTemp(InData);
+	Types.Reset();
+	Schemas.Reset();
+	Records.Reset();
+	MaterializedItems.Reset();
+
+	FMemoryReader Ar(Data);
+
+	uint32 FileMagic = 0;
+	int32 Version = 0;
+	Ar << FileMagic;
+	Ar << Version;
+
+	if (Ar.IsError() || FileMagic != Magic)
+	{
+		UE_LOG(LogInventorySystem, Warning, TEXT("FInventorySnapshot::Read failed - data is not an inventory snapshot"))
+		return false;
+	}
+
+	if (Version < static_cast<int32>(EVersion::Initial) || Version > static_cast<int32>(EVersion::Latest))
+	{
+		UE_LOG(LogInventorySystem, Warning, TEXT("FInventorySnapshot::Read failed - unsupported version %d"), Version)
+		return false;
+	}
+
+	int32 NumSchemas = 0;
+	if (ReadCount(Ar, NumSchemas))
+	{
+		Schemas.SetNum(NumSchemas);
+		for (FSchema& Schema : Schemas)
+		{
+			SerializeSchema(Ar, Schema);
+		}
+	}
+
+	int32 NumTypes = 0;
+	if (ReadCount(Ar, NumTypes))
+	{
+		Types.SetNum(NumTypes);
+		for (FTypeEntry& Entry : Types)
+		{
+			SerializeTypeEntry(Ar, Entry);
+
+			if (Entry.SchemaIndex >= Schemas.Num())
+			{
+				Ar.SetError();
+			}
+		}
+	}
+
+	// Only locate the item records here - the payloads are decoded when the items are accessed
+	int32 NumItems = 0;
+	if (ReadCount(Ar, NumItems))
+	{
+		Records.Reserve(NumItems);
+
+		for (int32 Index = 0; Index < NumItems && !Ar.IsError(); Index++)
+		{
+			uint32 TypeIndex = 0;
+			Ar.SerializeIntPacked(TypeIndex);
+
+			if (TypeIndex >= static_cast<uint32>(Types.Num()))
+			{
+				Ar.SetError();
+				break;
+			}
+
+			FItemRecord& Record = Records.AddDefaulted_GetRef();
+			Record.TypeIndex = TypeIndex;
+
+			const int32 SchemaIndex = Types[TypeIndex].SchemaIndex;
+			if (SchemaIndex != INDEX_NONE)
+			{
+				if (Schemas[SchemaIndex].bFixedLayout)
+				{
+					Record.PayloadSize = Schemas[SchemaIndex].PayloadSize;
+				}
+				else
+				{
+					ReadCount(Ar, Record.PayloadSize);
+				}
+			}
+
+			Record.PayloadOffset = Ar.Tell();
+			if (Record.PayloadOffset + Record.PayloadSize > Ar.TotalSize())
+			{
+				Ar.SetError();
+				break;
+			}
+
+			Ar.Seek(Record.PayloadOffset + Record.PayloadSize);
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogInventorySystem, Warning, TEXT("FInventorySnapshot::Read failed - snapshot data is corrupt"))
+		Records.Reset();
+		return false;
+	}
+
+	MaterializedItems.SetNum(Records.Num());
+	return true;
+}
+
+const FInventoryItem& FInventorySnapshot::GetItem(const int32 Index)
+{
+	check(Records.IsValidIndex(Index));
+
+	TOptional<FInventoryItem>& Item = MaterializedItems[Index];
+	if (!Item.IsSet())
+	{
+		Item = MaterializeItem(Records[Index]);
+	}
+
+	return Item.GetValue();
+}
+
+void FInventorySnapshot::MaterializeAll(TArray<FInventoryItem>& OutItems)
+{
+	OutItems.Reserve(OutItems.Num() + Records.Num());
+
+	for (int32 Index = 0; Index < Records.Num(); Index++)
+	{
+		TOptional<FInventoryItem>& Item = MaterializedItems[Index];
+		if (!Item.IsSet())
+		{
+			Item = MaterializeItem(Records[Index]);
+		}
+
+		if (Item->IsValid())
+		{
+			OutItems.Add(MoveTemp(Item.GetValue()));
+		}
+
+		Item.Reset();
+	}
+
+	// Every item was moved out, so nothing else can be read from the snapshot
+	Records.Reset();
+	MaterializedItems.Reset();
+}
+
+
+void FInventorySnapshot::ResolveTypes(TArray<UInventoryItemTypeBase*>& OutTypes)
+{
+	for (FTypeEntry& Entry : Types)
+	{
+		if (UInventoryItemTypeBase* Type = ResolveType(Entry))
+		{
+			OutTypes.Add(Type);
+		}
+
+		ResolveSchema(Entry.SchemaIndex);
+	}
+}
+
+
+
+// Serialization helpers
+
+FInventorySnapshot::FSchema FInventorySnapshot::MakeSchema(UScriptStruct* Struct)
+{
+	FSchema Schema;
+	Schema.StructPath = Struct->GetPathName();
+	Schema.Struct = Struct;
+	Schema.bFixedLayout = true;
+
+	for (TFieldIterator<FProperty> PropertyIt(Struct); PropertyIt; ++PropertyIt)
+	{
+		FSchemaField& Field = Schema.Fields.AddDefaulted_GetRef();
+		Field.Name = PropertyIt->GetName();
+		Field.CPPType = PropertyIt->GetCPPType();
+		Field.Size = PropertyIt->ElementSize * PropertyIt->ArrayDim;
+
+		Schema.bFixedLayout &= IsFixedLayoutProperty(*PropertyIt);
+		Schema.PayloadSize += Field.Size;
+
+		// Names are hashed by their characters, since name hashes aren't stable between runs
+		Schema.Hash = HashCombine(Schema.Hash, FCrc::StrCrc32(*Field.Name));
+		Schema.Hash = HashCombine(Schema.Hash, FCrc::StrCrc32(*Field.CPPType));
+		Schema.Hash = HashCombine(Schema.Hash, static_cast<uint32>(Field.Size));
+	}
+
+	if (!Schema.bFixedLayout)
+	{
+		Schema.PayloadSize = 0;
+	}
+
+	return Schema;
+}
+
+FInventorySnapshot::FTypeEntry FInventorySnapshot::MakeTypeEntry(UInventoryItemTypeBase* Type)
+{
+	FTypeEntry Entry;
+
+	if (!Type->IsAsset())
+	{
+		// Runtime types can't be referenced, so store enough to recreate them
+		Entry.Kind = ETypeReferenceKind::Dynamic;
+		Entry.Path = Type->GetClass()->GetPathName();
+
+		FMemoryWriter PropertyWriter(Entry.DynamicProperties);
+		FObjectAndNameAsStringProxyArchive PropertyAr(PropertyWriter, false);
+		Type->GetClass()->SerializeTaggedProperties(PropertyAr, reinterpret_cast<uint8*>(Type), Type->GetClass(),
+			reinterpret_cast<uint8*>(Type->GetClass()->GetDefaultObject()));
+		return Entry;
+	}
+
+	Entry.AssetID = Type->GetPrimaryAssetId();
+	const FSoftObjectPath TypePath(Type);
+
+	if (Entry.AssetID.IsValid() && UAssetManager::IsValid() && UAssetManager::Get().GetPrimaryAssetPath(Entry.AssetID) == TypePath)
+	{
+		Entry.Kind = ETypeReferenceKind::AssetID;
+	}
+	else
+	{
+		Entry.Kind = ETypeReferenceKind::ObjectPath;
+		Entry.Path = TypePath.ToString();
+	}
+
+	return Entry;
+}
+
+void FInventorySnapshot::SerializeSchema(FArchive& Ar, FSchema& Schema)
+{
+	Ar << Schema.StructPath;
+	Ar << Schema.Hash;
+
+	uint8 bFixedLayout = Schema.bFixedLayout;
+	Ar << bFixedLayout;
+	Schema.bFixedLayout = bFixedLayout != 0;
+
+	int32 NumFields = Schema.Fields.Num();
+	if (Ar.IsLoading())
+	{
+		if (!ReadCount(Ar, NumFields))
+		{
+			return;
+		}
+
+		Schema.Fields.SetNum(NumFields);
+	}
+	else
+	{
+		uint32 PackedNumFields = NumFields;
+		Ar.SerializeIntPacked(PackedNumFields);
+	}
+
+	for (FSchemaField& Field : Schema.Fields)
+	{
+		Ar << Field.Name;
+		Ar << Field.CPPType;
+		Ar << Field.Size;
+
+		if (Ar.IsLoading())
+		{
+			// Sizes come from the data, so make sure the payload size can't wrap around or exceed the data itself
+			const int64 PayloadSize = static_cast<int64>(Schema.PayloadSize) + Field.Size;
+
+			if (Field.Size < 0 || PayloadSize > Ar.TotalSize())
+			{
+				Ar.SetError();
+				return;
+			}
+
+			Schema.PayloadSize = Schema.bFixedLayout ? static_cast<int32>(PayloadSize) : 0;
+		}
+	}
+}
+
+void FInventorySnapshot::SerializeTypeEntry(FArchive& Ar, FTypeEntry& Entry)
+{
+	uint8 Kind = static_cast<uint8>(Entry.Kind);
+	Ar << Kind;
+	Entry.Kind = static_cast<ETypeReferenceKind>(Kind);
+
+	switch (Entry.Kind)
+	{
+	case ETypeReferenceKind::AssetID:
+		{
+			FString AssetIDString = Entry.AssetID.ToString();
+			Ar << AssetIDString;
+			Entry.AssetID = FPrimaryAssetId(AssetIDString);
+			break;
+		}
+	case ETypeReferenceKind::ObjectPath:
+		Ar << Entry.Path;
+		break;
+	case ETypeReferenceKind::Dynamic:
+		Ar << Entry.Path;
+		Ar << Entry.DynamicProperties;
+		break;
+	default:
+		Ar.SetError();
+		return;
+	}
+
+	// Schema indices are offset by one so that types without data can be written as 0
+	uint32 SchemaIndex = Entry.SchemaIndex + 1;
+	Ar.SerializeIntPacked(SchemaIndex);
+	Entry.SchemaIndex = static_cast<int32>(SchemaIndex) - 1;
+}
+
+void FInventorySnapshot::WritePayload(FArchive& Ar, const FSchema& Schema, const FInventoryItemDataBase& ItemData)
+{
+	if (Schema.bFixedLayout)
+	{
+		for (TFieldIterator<FProperty> PropertyIt(Schema.Struct); PropertyIt; ++PropertyIt)
+		{
+			Ar.Serialize(const_cast<void*>(PropertyIt->ContainerPtrToValuePtr<void>(&ItemData)), PropertyIt->ElementSize * PropertyIt->ArrayDim);
+		}
+
+		return;
+	}
+
+	// Other data structs are still written untagged, so they can only be read back while their schema matches
+	TArray<uint8> Payload;
+	FMemoryWriter PayloadWriter(Payload);
+	FObjectAndNameAsStringProxyArchive PayloadAr(PayloadWriter, false);
+	Schema.Struct->SerializeBin(PayloadAr, const_cast<FInventoryItemDataBase*>(&ItemData));
+
+	uint32 PayloadSize = Payload.Num();
+	Ar.SerializeIntPacked(PayloadSize);
+	Ar.Serialize(Payload.GetData(), Payload.Num());
+}
+
+UInventoryItemTypeBase* FInventorySnapshot::ResolveType(FTypeEntry& Entry)
+{
+	if (Entry.bResolved)
+	{
+		return Entry.Type;
+	}
+
+	check(IsInGameThread());
+	Entry.bResolved = true;
+
+	switch (Entry.Kind)
+	{
+	case ETypeReferenceKind::AssetID:
+		if (UAssetManager::IsValid())
+		{
+			Entry.Type = Cast<UInventoryItemTypeBase>(UAssetManager::Get().GetPrimaryAssetPath(Entry.AssetID).TryLoad());
+		}
+		break;
+	case ETypeReferenceKind::ObjectPath:
+		Entry.Type = Cast<UInventoryItemTypeBase>(FSoftObjectPath(Entry.Path).TryLoad());
+		break;
+	case ETypeReferenceKind::Dynamic:
+		{
+			UClass* TypeClass = LoadObject<UClass>(nullptr, *Entry.Path);
+			if (!TypeClass || !TypeClass->IsChildOf(UInventoryItemTypeBase::StaticClass()))
+			{
+				break;
+			}
+
+			Entry.Type = FInventoryItemTypePool::Get().Acquire(TypeClass);
+
+			FMemoryReader PropertyReader(Entry.DynamicProperties);
+			FObjectAndNameAsStringProxyArchive PropertyAr(PropertyReader, true);
+			TypeClass->SerializeTaggedProperties(PropertyAr, reinterpret_cast<uint8*>(Entry.Type), TypeClass,
+				reinterpret_cast<uint8*>(TypeClass->GetDefaultObject()));
+			Entry.Type->RefreshTypeTraits();
+			break;
+		}
+	}
+
+	if (!Entry.Type)
+	{
+		UE_LOG(LogInventorySystem, Warning, TEXT("FInventorySnapshot failed to resolve item type %s"),
+			Entry.Kind == ETypeReferenceKind::AssetID ? *Entry.AssetID.ToString() : *Entry.Path)
+	}
+
+	return Entry.Type;
+}
+
+FInventorySnapshot::FSchema* FInventorySnapshot::ResolveSchema(const int32 SchemaIndex)
+{
+	if (SchemaIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	FSchema& Schema = Schemas[SchemaIndex];
+	if (Schema.bResolved)
+	{
+		return &Schema;
+	}
+
+	check(IsInGameThread());
+	Schema.bResolved = true;
+	Schema.Struct = FindObject<UScriptStruct>(nullptr, *Schema.StructPath);
+
+	if (!Schema.Struct)
+	{
+		return &Schema;
+	}
+
+	const FSchema CurrentSchema = MakeSchema(Schema.Struct);
+	Schema.bMatchesStruct = CurrentSchema.Hash == Schema.Hash && CurrentSchema.bFixedLayout == Schema.bFixedLayout;
+
+	if (Schema.bFixedLayout && Schema.bMatchesStruct)
+	{
+		// Saved fields are in the same order as the current properties
+		int32 Offset = 0;
+
+		for (TFieldIterator<FProperty> PropertyIt(Schema.Struct); PropertyIt; ++PropertyIt)
+		{
+			FFieldMapping& Mapping = Schema.FieldMappings.AddDefaulted_GetRef();
+			Mapping.Property = *PropertyIt;
+			Mapping.Offset = Offset;
+			Mapping.Size = PropertyIt->ElementSize * PropertyIt->ArrayDim;
+			Offset += Mapping.Size;
+		}
+	}
+	else if (Schema.bFixedLayout)
+	{
+		// Match the saved fields to the current ones by name, so data survives fields being added or removed
+		int32 Offset = 0;
+
+		for (const FSchemaField& Field : Schema.Fields)
+		{
+			const FProperty* Property = FindFProperty<FProperty>(Schema.Struct, *Field.Name);
+
+			if (Property && IsFixedLayoutProperty(Property) && Property->GetCPPType() == Field.CPPType &&
+				Property->ElementSize * Property->ArrayDim == Field.Size)
+			{
+				FFieldMapping& Mapping = Schema.FieldMappings.AddDefaulted_GetRef();
+				Mapping.Property = Property;
+				Mapping.Offset = Offset;
+				Mapping.Size = Field.Size;
+			}
+
+			Offset += Field.Size;
+		}
+	}
+	else if (!Schema.bMatchesStruct)
+	{
+		UE_LOG(LogInventorySystem, Warning, TEXT("FInventorySnapshot - layout of %s changed, item data will use default values"),
+			*Schema.StructPath)
+	}
+
+	return &Schema;
+}
+
+FInventoryItem FInventorySnapshot::MaterializeItem(const FItemRecord& Record)
+{
+	FTypeEntry& Entry = Types[Record.TypeIndex];
+	FInventoryItem Item(ResolveType(Entry));
+	FInventoryItemDataBase* ItemData = Item.GetData();
+	const FSchema* Schema = ResolveSchema(Entry.SchemaIndex);
+
+	if (!ItemData || !Schema || Schema->Struct != ItemData->GetScriptStruct())
+	{
+		// The type no longer uses the same data, so it keeps its defaults
+		return Item;
+	}
+
+	const uint8* Payload = Data.GetData() + Record.PayloadOffset;
+
+	if (Schema->bFixedLayout)
+	{
+		for (const FFieldMapping& Mapping : Schema->FieldMappings)
+		{
+			FMemory::Memcpy(Mapping.Property->ContainerPtrToValuePtr<void>(ItemData), Payload + Mapping.Offset, Mapping.Size);
+		}
+	}
+	else if (Schema->bMatchesStruct)
+	{
+		FMemoryReader PayloadReader(Data);
+		PayloadReader.Seek(Record.PayloadOffset);
+		FObjectAndNameAsStringProxyArchive PayloadAr(PayloadReader, true);
+		Schema->Struct->SerializeBin(PayloadAr, ItemData);
+	}
+
+	return Item;
+}
+
+
+
+// FInventorySnapshot::FWriter
+
+FInventorySnapshot::FWriter::FWriter(TArrayView<const FInventoryItem> InItems)
+{
+	TMap<const UInventoryItemTypeBase*, int32> TypeIndices;
+	TMap<const UScriptStruct*, int32> SchemaIndices;
+	FMemoryWriter RecordWriter(ItemRecords);
+
+	// Build the tables up front, so each type and data struct is only described once
+	for (const FInventoryItem& Item : InItems)
+	{
+		UInventoryItemTypeBase* Type = Item.GetType();
+		if (!Type)
+		{
+			continue;
+		}
+
+		int32* TypeIndex = TypeIndices.Find(Type);
+		if (!TypeIndex)
+		{
+			FTypeEntry Entry = MakeTypeEntry(Type);
+
+			if (UScriptStruct* DataStruct = Type->GetItemDataType())
+			{
+				int32* SchemaIndex = SchemaIndices.Find(DataStruct);
+				Entry.SchemaIndex = SchemaIndex ? *SchemaIndex : SchemaIndices.Add(DataStruct, Schemas.Add(MakeSchema(DataStruct)));
+			}
+
+			TypeIndex = &TypeIndices.Add(Type, Types.Add(MoveTemp(Entry)));
+		}
+
+		// Payloads are encoded here too, since tagged and untagged struct serialization aren't safe off the game thread
+		uint32 SerializedTypeIndex = *TypeIndex;
+		RecordWriter.SerializeIntPacked(SerializedTypeIndex);
+
+		const int32 SchemaIndex = Types[*TypeIndex].SchemaIndex;
+		if (SchemaIndex != INDEX_NONE)
+		{
+			// Items always have data when their type has a data struct
+			check(Item.GetData());
+			WritePayload(RecordWriter, Schemas[SchemaIndex], *Item.GetData());
+		}
+
+		NumItems++;
+	}
+}
+
+void FInventorySnapshot::FWriter::Write(TArray<uint8>& OutData) const
+{
+	OutData.Reset();
+	FMemoryWriter Ar(OutData);
+
+	uint32 FileMagic = Magic;
+	int32 Version = static_cast<int32>(EVersion::Latest);
+	Ar << FileMagic;
+	Ar << Version;
+
+	uint32 NumSchemas = Schemas.Num();
+	Ar.SerializeIntPacked(NumSchemas);
+	for (const FSchema& Schema : Schemas)
+	{
+		SerializeSchema(Ar, const_cast<FSchema&>(Schema));
+	}
+
+	uint32 NumTypes = Types.Num();
+	Ar.SerializeIntPacked(NumTypes);
+	for (const FTypeEntry& Entry : Types)
+	{
+		SerializeTypeEntry(Ar, const_cast<FTypeEntry&>(Entry));
+	}
+
+	uint32 SerializedNumItems = NumItems;
+	Ar.SerializeIntPacked(SerializedNumItems);
+	Ar.Serialize(const_cast<uint8*>(ItemRecords.GetData()), ItemRecords.Num());
+}
@@ -0,0 +1,228 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "CoreMinimal.h"
+#include "InventorySystem.h"
+#include "Inventory/InventorySnapshot.h"
+#include "Inventory/Components/InventoryComponent.h"
+#include "Inventory/ItemTypes/ItemTypePool.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/UObjectIterator.h"
+
+#if !UE_BUILD_SHIPPING
+
+
+
+namespace
+{
+	/**
+	 * Checks that items loaded from a snapshot match the items it was written from. Snapshots skip items without a
+	 * type, so those aren't expected to come back
+	 * @return Number of items that didn't match
+	 */
+	int32 VerifyLoadedItems(const TArray<FInventoryItem>& Items, const TArray<FInventoryItem>& LoadedItems)
+	{
+		TArray<const FInventoryItem*> SavedItems;
+		for (const FInventoryItem& Item : Items)
+		{
+			if (Item.GetType())
+			{
+				SavedItems.Add(&Item);
+			}
+		}
+
+		if (SavedItems.Num() != LoadedItems.Num())
+		{
+			UE_LOG(LogInventorySystem, Warning, TEXT("Inventory.BenchmarkSnapshot - saved %d items but loaded %d"),
+				SavedItems.Num(), LoadedItems.Num())
+			return FMath::Max(SavedItems.Num(), LoadedItems.Num());
+		}
+
+		int32 NumMismatched = 0;
+		for (int32 Index = 0; Index < LoadedItems.Num(); Index++)
+		{
+			const FInventoryItem& Saved = *SavedItems[Index];
+			const FInventoryItem& Loaded = LoadedItems[Index];
+
+			bool bMatches = Loaded.GetType() && *Saved.GetType() == *Loaded.GetType();
+
+			if (bMatches)
+			{
+				const FInventoryItemDataBase* SavedData = Saved.GetData();
+				const FInventoryItemDataBase* LoadedData = Loaded.GetData();
+
+				if (!SavedData || !LoadedData)
+				{
+					bMatches = SavedData == LoadedData;
+				}
+				else
+				{
+					UScriptStruct* Struct = SavedData->GetScriptStruct();
+					bMatches = Struct == LoadedData->GetScriptStruct() &&
+						Struct->CompareScriptStruct(SavedData, LoadedData, PPF_None);
+				}
+			}
+
+			if (!bMatches)
+			{
+				UE_LOG(LogInventorySystem, Warning, TEXT("Inventory.BenchmarkSnapshot - item %d (%s) doesn't match after loading"),
+					Index, *GetNameSafe(Saved.GetType()))
+				NumMismatched++;
+			}
+		}
+
+		return NumMismatched;
+	}
+
+	/**
+	 * Compares saving and loading every inventory in the world with tagged item serialization against snapshots.
+	 * Usage: Inventory.BenchmarkSnapshot [Iterations]
+	 */
+	void BenchmarkSnapshot(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100;
+
+		TArray<const UInventoryComponent*> Components;
+		int32 NumItems = 0;
+
+		for (TObjectIterator<UInventoryComponent> ComponentIt; ComponentIt; ++ComponentIt)
+		{
+			if (ComponentIt->GetWorld() == World && !ComponentIt->IsTemplate())
+			{
+				Components.Add(*ComponentIt);
+				NumItems += ComponentIt->GetArray().Num();
+			}
+		}
+
+		if (NumItems == 0)
+		{
+			UE_LOG(LogInventorySystem, Display, TEXT("Inventory.BenchmarkSnapshot - no inventory items to benchmark"))
+			return;
+		}
+
+		TArray<TArray<uint8>> TaggedData;
+		TArray<TArray<uint8>> SnapshotData;
+		TaggedData.SetNum(Components.Num());
+		SnapshotData.SetNum(Components.Num());
+
+		double TaggedSaveTime = 0.0;
+		double TaggedLoadTime = 0.0;
+		double SnapshotSaveTime = 0.0;
+		double SnapshotReadTime = 0.0;
+		double SnapshotLoadTime = 0.0;
+		int32 NumMismatched = 0;
+
+		for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+		{
+			for (int32 Index = 0; Index < Components.Num(); Index++)
+			{
+				const TArray<FInventoryItem>& Items = Components[Index]->GetArray();
+
+				// Tagged serialization, as the items are saved as part of their component
+				double StartTime = FPlatformTime::Seconds();
+				{
+					TaggedData[Index].Reset();
+					FMemoryWriter Writer(TaggedData[Index]);
+					FObjectAndNameAsStringProxyArchive Ar(Writer, false);
+
+					int32 Num = Items.Num();
+					Ar << Num;
+					for (const FInventoryItem& Item : Items)
+					{
+						const_cast<FInventoryItem&>(Item).Serialize(Ar);
+					}
+				}
+				TaggedSaveTime += FPlatformTime::Seconds() - StartTime;
+
+				StartTime = FPlatformTime::Seconds();
+				{
+					FMemoryReader Reader(TaggedData[Index]);
+					FObjectAndNameAsStringProxyArchive Ar(Reader, true);
+
+					int32 Num = 0;
+					Ar << Num;
+					TArray<FInventoryItem> LoadedItems;
+					LoadedItems.SetNum(Num);
+					for (FInventoryItem& Item : LoadedItems)
+					{
+						Item.Serialize(Ar);
+					}
+				}
+				TaggedLoadTime += FPlatformTime::Seconds() - StartTime;
+
+				// Snapshots, timing the table parsing separately from materializing the items
+				StartTime = FPlatformTime::Seconds();
+				FInventorySnapshot::Write(Items, SnapshotData[Index]);
+				SnapshotSaveTime += FPlatformTime::Seconds() - StartTime;
+
+				StartTime = FPlatformTime::Seconds();
+				FInventorySnapshot Snapshot;
+				TArray<uint8> Data = SnapshotData[Index];
+				Snapshot.Read(MoveTemp(Data));
+				SnapshotReadTime += FPlatformTime::Seconds() - StartTime;
+
+				StartTime = FPlatformTime::Seconds();
+				TArray<FInventoryItem> LoadedItems;
+				Snapshot.MaterializeAll(LoadedItems);
+				SnapshotLoadTime += FPlatformTime::Seconds() - StartTime;
+
+				// Timings mean nothing if the items don't survive the round trip, so check them once
+				if (Iteration == 0)
+				{
+					NumMismatched += VerifyLoadedItems(Items, LoadedItems);
+				}
+
+				// Dynamic types are acquired from the pool once per snapshot type table entry, so give each one back,
+				// or every iteration would create new types
+				TSet<UInventoryItemTypeBase*> LoadedTypes;
+				for (const FInventoryItem& Item : LoadedItems)
+				{
+					LoadedTypes.Add(Item.GetType());
+				}
+
+				LoadedItems.Empty();
+
+				for (UInventoryItemTypeBase* LoadedType : LoadedTypes)
+				{
+					FInventoryItemTypePool::Get().Release(LoadedType);
+				}
+			}
+		}
+
+		int64 TaggedBytes = 0;
+		int64 SnapshotBytes = 0;
+		for (int32 Index = 0; Index < Components.Num(); Index++)
+		{
+			TaggedBytes += TaggedData[Index].Num();
+			SnapshotBytes += SnapshotData[Index].Num();
+		}
+
+		const double Scale = 1000.0 / Iterations;
+		UE_LOG(LogInventorySystem, Display, TEXT("Inventory.BenchmarkSnapshot - %d inventories, %d items, %d iterations"),
+			Components.Num(), NumItems, Iterations)
+		UE_LOG(LogInventorySystem, Display, TEXT("  Tagged:   %lld bytes, save %.3f ms, load %.3f ms"),
+			TaggedBytes, TaggedSaveTime * Scale, TaggedLoadTime * Scale)
+		UE_LOG(LogInventorySystem, Display, TEXT("  Snapshot: %lld bytes, save %.3f ms, read %.3f ms, load %.3f ms"),
+			SnapshotBytes, SnapshotSaveTime * Scale, SnapshotReadTime * Scale, SnapshotLoadTime * Scale)
+
+		if (NumMismatched > 0)
+		{
+			UE_LOG(LogInventorySystem, Warning, TEXT("  Round trip: FAILED, %d items didn't match after loading"), NumMismatched)
+		}
+		else
+		{
+			UE_LOG(LogInventorySystem, Display, TEXT("  Round trip: passed"))
+		}
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs BenchmarkSnapshotCommand(
+		TEXT("Inventory.BenchmarkSnapshot"),
+		TEXT("Compares saving and loading every inventory in the world with tagged serialization against snapshots. ")
+		TEXT("Usage: Inventory.BenchmarkSnapshot [Iterations]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkSnapshot));
+}
+
+#endif
@@ -0,0 +1,242 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/InventorySortIndex.h"
+#include "Inventory/InventoryItem.h"
+#include "Inventory/ItemTypes/ItemTypeBase.h"
+
+
+
+// FInventorySortIndex
+
+// Index modification
+
+void FInventorySortIndex::Reset()
+{
+	Keys.Reset();
+
+	for (int32 ModeIndex = 0; ModeIndex < NumSortModes; ModeIndex++)
+	{
+		SortedViews[ModeIndex].Reset();
+		bViewSorted[ModeIndex] = false;
+	}
+
+	bBuilt = false;
+}
+
+void FInventorySortIndex::Build(const TArray<FInventoryItem>& Items)
+{
+	Reset();
+
+	Keys.Reserve(Items.Num());
+	for (const FInventoryItem& Item : Items)
+	{
+		Keys.Add(Item.GetUniqueID(), MakeKeys(Item));
+	}
+
+	bBuilt = true;
+}
+
+void FInventorySortIndex::AddItem(const FInventoryItem& Item)
+{
+	if (!bBuilt)
+	{
+		return;
+	}
+
+	Keys.Add(Item.GetUniqueID(), MakeKeys(Item));
+	InsertIntoViews(Item.GetUniqueID());
+}
+
+void FInventorySortIndex::UpdateItem(const FInventoryItem& Item)
+{
+	if (!bBuilt)
+	{
+		return;
+	}
+
+	const int32 ItemID = Item.GetUniqueID();
+	FInventorySortKeys NewKeys = MakeKeys(Item);
+	const FInventorySortKeys* OldKeys = Keys.Find(ItemID);
+
+	if (OldKeys && OldKeys->NameKey == NewKeys.NameKey && OldKeys->TypeKey == NewKeys.TypeKey &&
+		OldKeys->StackCount == NewKeys.StackCount)
+	{
+		// Nothing that affects the order changed
+		return;
+	}
+
+	// Items are found in the views with their old keys, so remove before replacing them
+	if (OldKeys)
+	{
+		RemoveFromViews(ItemID);
+	}
+
+	Keys.Add(ItemID, MoveTemp(NewKeys));
+	InsertIntoViews(ItemID);
+}
+
+void FInventorySortIndex::RemoveItem(const int32 ItemID)
+{
+	if (!bBuilt || !Keys.Contains(ItemID))
+	{
+		return;
+	}
+
+	RemoveFromViews(ItemID);
+	Keys.Remove(ItemID);
+}
+
+
+
+// Queries
+
+const TArray<int32>& FInventorySortIndex::GetSortedItemIDs(const EInventorySortMode SortMode)
+{
+	const int32 ModeIndex = static_cast<int32>(SortMode);
+	check(ModeIndex >= 0 && ModeIndex < NumSortModes);
+
+	TArray<int32>& SortedView = SortedViews[ModeIndex];
+
+	if (!bViewSorted[ModeIndex])
+	{
+		// Full sort only happens the first time a view is used
+		Keys.GetKeys(SortedView);
+		SortedView.Sort([this, SortMode](const int32 ItemA, const int32 ItemB)
+		{
+			return IsLess(SortMode, ItemA, ItemB);
+		});
+
+		bViewSorted[ModeIndex] = true;
+	}
+
+	return SortedView;
+}
+
+void FInventorySortIndex::SearchByName(const FString& SearchText, const EInventorySortMode SortMode, TArray<int32>& OutItemIDs)
+{
+	const FString LowerSearchText = SearchText.ToLower();
+
+	for (const int32 ItemID : GetSortedItemIDs(SortMode))
+	{
+		// Both strings are already lowercase, so a case sensitive search is enough
+		if (Keys.FindChecked(ItemID).NameKey.Contains(LowerSearchText, ESearchCase::CaseSensitive))
+		{
+			OutItemIDs.Add(ItemID);
+		}
+	}
+}
+
+
+
+// Helper functions
+
+FInventorySortKeys FInventorySortIndex::MakeKeys(const FInventoryItem& Item)
+{
+	FInventorySortKeys NewKeys;
+	NewKeys.NameKey = Item.GetName().ToLower().ToString();
+	NewKeys.StackCount = Item.GetStackCount();
+
+	if (const UInventoryItemTypeBase* Type = Item.GetType())
+	{
+		// Runtime types get generated object names that differ between equal types, so key them the way they're
+		// compared - by class and type hash - to keep equal types next to each other
+		NewKeys.TypeKey = Type->IsAsset() ? Type->GetPathName().ToLower() :
+			FString::Printf(TEXT("%s:%08x"), *Type->GetClass()->GetPathName().ToLower(), Type->GetItemTypeHash());
+	}
+
+	return NewKeys;
+}
+
+bool FInventorySortIndex::IsLess(const EInventorySortMode SortMode, const int32 ItemA, const int32 ItemB) const
+{
+	const FInventorySortKeys& KeysA = Keys.FindChecked(ItemA);
+	const FInventorySortKeys& KeysB = Keys.FindChecked(ItemB);
+
+	switch (SortMode)
+	{
+		case EInventorySortMode::Type:
+		{
+			const int32 TypeComparison = KeysA.TypeKey.Compare(KeysB.TypeKey, ESearchCase::CaseSensitive);
+			if (TypeComparison != 0)
+			{
+				return TypeComparison < 0;
+			}
+			break;
+		}
+
+		case EInventorySortMode::StackCount:
+		{
+			if (KeysA.StackCount != KeysB.StackCount)
+			{
+				return KeysA.StackCount > KeysB.StackCount;
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	const int32 NameComparison = KeysA.NameKey.Compare(KeysB.NameKey, ESearchCase::CaseSensitive);
+	if (NameComparison != 0)
+	{
+		return NameComparison < 0;
+	}
+
+	// Fall back to the ID so that the order is strict, which lets items be found again by binary search
+	return ItemA < ItemB;
+}
+
+void FInventorySortIndex::InsertIntoViews(const int32 ItemID)
+{
+	for (int32 ModeIndex = 0; ModeIndex < NumSortModes; ModeIndex++)
+	{
+		if (bViewSorted[ModeIndex])
+		{
+			SortedViews[ModeIndex].Insert(ItemID, LowerBound(static_cast<EInventorySortMode>(ModeIndex), ItemID));
+		}
+	}
+}
+
+void FInventorySortIndex::RemoveFromViews(const int32 ItemID)
+{
+	for (int32 ModeIndex = 0; ModeIndex < NumSortModes; ModeIndex++)
+	{
+		if (!bViewSorted[ModeIndex])
+		{
+			continue;
+		}
+
+		TArray<int32>& SortedView = SortedViews[ModeIndex];
+		const int32 Position = LowerBound(static_cast<EInventorySortMode>(ModeIndex), ItemID);
+
+		if (SortedView.IsValidIndex(Position) && SortedView[Position] == ItemID)
+		{
+			SortedView.RemoveAt(Position, 1, false);
+		}
+	}
+}
+
+int32 FInventorySortIndex::LowerBound(const EInventorySortMode SortMode, const int32 ItemID) const
+{
+	const TArray<int32>& SortedView = SortedViews[static_cast<int32>(SortMode)];
+
+	int32 Low = 0;
+	int32 High = SortedView.Num();
+
+	while (Low < High)
+	{
+		const int32 Middle = Low + (High - Low) / 2;
+
+		if (IsLess(SortMode, SortedView[Middle], ItemID))
+		{
+			Low = Middle + 1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	return Low;
+}
@@ -0,0 +1,302 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/InventoryTagIndex.h"
+
+
+
+// FInventorySlotSet
+
+// Set operations
+
+void FInventorySlotSet::Add(const int32 SlotIndex)
+{
+	check(SlotIndex >= 0);
+
+	const int32 WordIndex = SlotIndex / BitsPerWord;
+	if (WordIndex >= Words.Num())
+	{
+		Words.AddZeroed(WordIndex - Words.Num() + 1);
+	}
+
+	Words[WordIndex] |= 1u << (SlotIndex % BitsPerWord);
+}
+
+void FInventorySlotSet::Remove(const int32 SlotIndex)
+{
+	const int32 WordIndex = SlotIndex / BitsPerWord;
+	if (!Words.IsValidIndex(WordIndex))
+	{
+		return;
+	}
+
+	Words[WordIndex] &= ~(1u << (SlotIndex % BitsPerWord));
+}
+
+bool FInventorySlotSet::Contains(const int32 SlotIndex) const
+{
+	const int32 WordIndex = SlotIndex / BitsPerWord;
+	if (!Words.IsValidIndex(WordIndex))
+	{
+		return false;
+	}
+
+	return (Words[WordIndex] & (1u << (SlotIndex % BitsPerWord))) != 0;
+}
+
+bool FInventorySlotSet::IsEmpty() const
+{
+	for (const uint32 Word : Words)
+	{
+		if (Word)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 FInventorySlotSet::Num() const
+{
+	int32 Count = 0;
+
+	for (const uint32 Word : Words)
+	{
+		Count += static_cast<int32>(FMath::CountBits(Word));
+	}
+
+	return Count;
+}
+
+FInventorySlotSet& FInventorySlotSet::operator&=(const FInventorySlotSet& Other)
+{
+	// Anything past the end of the other set is implicitly zero
+	Words.SetNum(FMath::Min(Words.Num(), Other.Words.Num()), false);
+
+	for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+	{
+		Words[WordIndex] &= Other.Words[WordIndex];
+	}
+
+	return *this;
+}
+
+FInventorySlotSet& FInventorySlotSet::operator|=(const FInventorySlotSet& Other)
+{
+	if (Other.Words.Num() > Words.Num())
+	{
+		Words.AddZeroed(Other.Words.Num() - Words.Num());
+	}
+
+	for (int32 WordIndex = 0; WordIndex < Other.Words.Num(); WordIndex++)
+	{
+		Words[WordIndex] |= Other.Words[WordIndex];
+	}
+
+	return *this;
+}
+
+FInventorySlotSet& FInventorySlotSet::Subtract(const FInventorySlotSet& Other)
+{
+	const int32 CommonWords = FMath::Min(Words.Num(), Other.Words.Num());
+
+	for (int32 WordIndex = 0; WordIndex < CommonWords; WordIndex++)
+	{
+		Words[WordIndex] &= ~Other.Words[WordIndex];
+	}
+
+	return *this;
+}
+
+
+
+
+// FInventoryTagIndex
+
+// Index modification
+
+void FInventoryTagIndex::AddSlot(const int32 SlotIndex, const FGameplayTagContainer& Tags)
+{
+	AllSlots.Add(SlotIndex);
+
+	// Include parent tags so that queries for a parent tag match its children, like FGameplayTagContainer::HasTag
+	const FGameplayTagContainer TagsWithParents = Tags.GetGameplayTagParents();
+
+	for (const FGameplayTag& Tag : TagsWithParents)
+	{
+		TagToSlots.FindOrAdd(Tag).Add(SlotIndex);
+	}
+}
+
+void FInventoryTagIndex::UpdateSlot(const int32 SlotIndex, const FGameplayTagContainer& Tags)
+{
+	if (!AllSlots.Contains(SlotIndex))
+	{
+		AddSlot(SlotIndex, Tags);
+		return;
+	}
+
+	const FGameplayTagContainer TagsWithParents = Tags.GetGameplayTagParents();
+
+	// Like removal, visiting every indexed tag is cheap since there are only a handful of them
+	for (TPair<FGameplayTag, FInventorySlotSet>& TagSlots : TagToSlots)
+	{
+		if (TagsWithParents.HasTagExact(TagSlots.Key))
+		{
+			TagSlots.Value.Add(SlotIndex);
+		}
+		else
+		{
+			TagSlots.Value.Remove(SlotIndex);
+		}
+	}
+
+	for (const FGameplayTag& Tag : TagsWithParents)
+	{
+		// Tags that weren't indexed before still need an entry
+		if (!TagToSlots.Contains(Tag))
+		{
+			TagToSlots.Add(Tag).Add(SlotIndex);
+		}
+	}
+}
+
+void FInventoryTagIndex::RemoveSlot(const int32 SlotIndex)
+{
+	if (!AllSlots.Contains(SlotIndex))
+	{
+		return;
+	}
+
+	AllSlots.Remove(SlotIndex);
+
+	// Inventories only use a handful of distinct tags, so clearing the bit everywhere is cheaper than tracking the
+	// tags of every slot
+	for (TPair<FGameplayTag, FInventorySlotSet>& TagSlots : TagToSlots)
+	{
+		TagSlots.Value.Remove(SlotIndex);
+	}
+}
+
+void FInventoryTagIndex::Reset()
+{
+	TagToSlots.Reset();
+	AllSlots.Reset();
+}
+
+
+
+// Queries
+
+FInventorySlotSet FInventoryTagIndex::Evaluate(const FGameplayTagQuery& Query) const
+{
+	if (Query.IsEmpty())
+	{
+		// Empty queries never match anything
+		return FInventorySlotSet();
+	}
+
+	FGameplayTagQueryExpression RootExpression;
+	Query.GetQueryExpr(RootExpression);
+
+	return EvaluateExpression(RootExpression);
+}
+
+FInventorySlotSet FInventoryTagIndex::FindSlotsWithTag(const FGameplayTag& Tag) const
+{
+	const FInventorySlotSet* Slots = TagToSlots.Find(Tag);
+	if (!Slots)
+	{
+		return FInventorySlotSet();
+	}
+
+	return *Slots;
+}
+
+
+
+// Helper functions
+
+FInventorySlotSet FInventoryTagIndex::EvaluateExpression(const FGameplayTagQueryExpression& Expression) const
+{
+	// Empty tag and expression sets follow the same rules as FGameplayTagQuery::Matches
+	switch (Expression.ExprType)
+	{
+		case EGameplayTagQueryExprType::AnyTagsMatch:
+		{
+			return UnionOfTags(Expression.TagSet);
+		}
+
+		case EGameplayTagQueryExprType::AllTagsMatch:
+		{
+			FInventorySlotSet Result = AllSlots;
+			for (const FGameplayTag& Tag : Expression.TagSet)
+			{
+				const FInventorySlotSet* TagSlots = TagToSlots.Find(Tag);
+				if (!TagSlots)
+				{
+					return FInventorySlotSet();
+				}
+
+				Result &= *TagSlots;
+			}
+			return Result;
+		}
+
+		case EGameplayTagQueryExprType::NoTagsMatch:
+		{
+			FInventorySlotSet Result = AllSlots;
+			Result.Subtract(UnionOfTags(Expression.TagSet));
+			return Result;
+		}
+
+		case EGameplayTagQueryExprType::AnyExprMatch:
+		{
+			FInventorySlotSet Result;
+			for (const FGameplayTagQueryExpression& SubExpression : Expression.ExprSet)
+			{
+				Result |= EvaluateExpression(SubExpression);
+			}
+			return Result;
+		}
+
+		case EGameplayTagQueryExprType::AllExprMatch:
+		{
+			FInventorySlotSet Result = AllSlots;
+			for (const FGameplayTagQueryExpression& SubExpression : Expression.ExprSet)
+			{
+				Result &= EvaluateExpression(SubExpression);
+			}
+			return Result;
+		}
+
+		case EGameplayTagQueryExprType::NoExprMatch:
+		{
+			FInventorySlotSet Result = AllSlots;
+			for (const FGameplayTagQueryExpression& SubExpression : Expression.ExprSet)
+			{
+				Result.Subtract(EvaluateExpression(SubExpression));
+			}
+			return Result;
+		}
+
+		default:
+			return FInventorySlotSet();
+	}
+}
+
+FInventorySlotSet FInventoryTagIndex::UnionOfTags(const TArray<FGameplayTag>& Tags) const
+{
+	FInventorySlotSet Result;
+
+	for (const FGameplayTag& Tag : Tags)
+	{
+		const FInventorySlotSet* TagSlots = TagToSlots.Find(Tag);
+		if (TagSlots)
+		{
+			Result |= *TagSlots;
+		}
+	}
+
+	return Result;
+}
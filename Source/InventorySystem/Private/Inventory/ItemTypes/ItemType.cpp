@@ -1,6 +1,7 @@
 ﻿// Copyright (c) 2020 Spencer Melnick
 
 #include "Inventory/ItemTypes/ItemType.h"
+#include "Inventory/DataTypes/ItemData.h"
 
 
 // UInventoryItemType
@@ -12,6 +13,11 @@ bool UInventoryItemType::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, boo
 	Ar << PreviewActorClass;
 	Ar << bAllowsDuplicates;
 
+	// Clients keep their own running totals, so they need the contributions of dynamic types as well
+	FInventoryNetQuantization::SerializeFixedPoint(Ar, UnitWeight, FInventoryNetQuantization::ContributionScale);
+	FInventoryNetQuantization::SerializeFixedPoint(Ar, UnitValue, FInventoryNetQuantization::ContributionScale);
+	FInventoryNetQuantization::SerializePackedInt(Ar, SlotCost);
+
 	bOutSuccess = true;
 	return true;
 }
@@ -33,3 +39,8 @@ bool UInventoryItemType::operator==(const UInventoryItemType& OtherType) const
 	return GetPrimaryAssetId() == OtherType.GetPrimaryAssetId();
 }
 
+uint32 UInventoryItemType::GetItemTypeHash() const
+{
+	return HashCombine(Super::GetItemTypeHash(), GetTypeHash(GetPrimaryAssetId()));
+}
+
@@ -0,0 +1,49 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/ItemTypes/ItemTypeBase.h"
+#include "Inventory/DataTypes/ItemData.h"
+
+
+// UInventoryItemTypeBase
+
+// UObject overrides
+
+void UInventoryItemTypeBase::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	RefreshTypeTraits();
+}
+
+void UInventoryItemTypeBase::PostLoad()
+{
+	Super::PostLoad();
+
+	RefreshTypeTraits();
+}
+
+#if WITH_EDITOR
+void UInventoryItemTypeBase::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	RefreshTypeTraits();
+}
+#endif
+
+
+
+// Type traits
+
+void UInventoryItemTypeBase::RefreshTypeTraits()
+{
+	TypeTraits = FInventoryItemTypeTraits();
+	TypeTraits.DataType = GetItemDataType();
+	TypeTraits.bAllowsDuplicates = AllowsDuplicates();
+	TypeTraits.bAllowsStacking = AllowsStacking();
+
+	// Contributions are rounded to the precision they replicate with, so that servers and clients keep the same totals
+	TypeTraits.UnitWeight = FInventoryNetQuantization::QuantizeFixedPoint(FMath::Max(0.f, GetUnitWeight()), FInventoryNetQuantization::ContributionScale);
+	TypeTraits.UnitValue = FInventoryNetQuantization::QuantizeFixedPoint(GetUnitValue(), FInventoryNetQuantization::ContributionScale);
+	TypeTraits.SlotCost = FMath::Max(0, GetSlotCost());
+}
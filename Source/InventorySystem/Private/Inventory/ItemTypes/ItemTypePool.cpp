@@ -0,0 +1,130 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/ItemTypes/ItemTypePool.h"
+#include "Inventory/ItemTypes/ItemTypeBase.h"
+
+
+// FInventoryItemTypePool
+
+TUniquePtr<FInventoryItemTypePool> FInventoryItemTypePool::Instance;
+
+FInventoryItemTypePool& FInventoryItemTypePool::Get()
+{
+	if (!Instance)
+	{
+		Instance = MakeUnique<FInventoryItemTypePool>();
+	}
+
+	return *Instance;
+}
+
+void FInventoryItemTypePool::Shutdown()
+{
+	Instance.Reset();
+}
+
+
+
+// Pool operations
+
+UInventoryItemTypeBase* FInventoryItemTypePool::Acquire(UClass* TypeClass)
+{
+	check(TypeClass && TypeClass->IsChildOf(UInventoryItemTypeBase::StaticClass()));
+
+	TArray<UInventoryItemTypeBase*>* ClassFreeTypes = FreeTypes.Find(TypeClass);
+
+	if (!ClassFreeTypes || ClassFreeTypes->Num() == 0)
+	{
+		ReclaimReleasedTypes(TypeClass);
+		ClassFreeTypes = FreeTypes.Find(TypeClass);
+	}
+
+	if (ClassFreeTypes && ClassFreeTypes->Num() > 0)
+	{
+		return ClassFreeTypes->Pop(false);
+	}
+
+	UInventoryItemTypeBase* NewType = NewObject<UInventoryItemTypeBase>(static_cast<UObject*>(GetTransientPackage()), TypeClass);
+	NewType->bPooled = true;
+	return NewType;
+}
+
+void FInventoryItemTypePool::Release(UInventoryItemTypeBase* ItemType)
+{
+	if (!ItemType || !ItemType->bPooled)
+	{
+		return;
+	}
+
+	// The releasing item (and any copies of it) may still refer to the type, so it can't be reset yet
+	TArray<UInventoryItemTypeBase*>& ClassReleasedTypes = ReleasedTypes.FindOrAdd(ItemType->GetClass());
+	ClassReleasedTypes.Add(ItemType);
+
+	if (ClassReleasedTypes.Num() % MaxFreeTypesPerClass == 0)
+	{
+		// Don't keep more types alive than needed when this class isn't being acquired anymore
+		ReclaimReleasedTypes(ItemType->GetClass());
+	}
+}
+
+void FInventoryItemTypePool::ReclaimReleasedTypes(UClass* TypeClass)
+{
+	TArray<UInventoryItemTypeBase*>* ClassReleasedTypes = ReleasedTypes.Find(TypeClass);
+	if (!ClassReleasedTypes)
+	{
+		return;
+	}
+
+	TArray<UInventoryItemTypeBase*>& ClassFreeTypes = FreeTypes.FindOrAdd(TypeClass);
+
+	for (int32 Index = ClassReleasedTypes->Num() - 1; Index >= 0; Index--)
+	{
+		UInventoryItemTypeBase* ItemType = (*ClassReleasedTypes)[Index];
+
+		if (ItemType->HasItemReferences())
+		{
+			continue;
+		}
+
+		ClassReleasedTypes->RemoveAtSwap(Index, 1, false);
+
+		if (ClassFreeTypes.Num() < MaxFreeTypesPerClass)
+		{
+			ResetType(ItemType);
+			ClassFreeTypes.Add(ItemType);
+		}
+
+		// Otherwise let the garbage collector have it
+	}
+}
+
+void FInventoryItemTypePool::ResetType(UInventoryItemTypeBase* ItemType)
+{
+	UClass* TypeClass = ItemType->GetClass();
+	const UObject* ClassDefaults = TypeClass->GetDefaultObject();
+
+	for (TFieldIterator<FProperty> PropertyIt(TypeClass); PropertyIt; ++PropertyIt)
+	{
+		PropertyIt->CopyCompleteValue_InContainer(ItemType, ClassDefaults);
+	}
+
+	ItemType->RefreshTypeTraits();
+}
+
+
+
+// FGCObject overrides
+
+void FInventoryItemTypePool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<UClass*, TArray<UInventoryItemTypeBase*>>& ClassFreeTypes : FreeTypes)
+	{
+		Collector.AddReferencedObjects(ClassFreeTypes.Value);
+	}
+
+	// Copies of released items don't keep their types alive on their own
+	for (TPair<UClass*, TArray<UInventoryItemTypeBase*>>& ClassReleasedTypes : ReleasedTypes)
+	{
+		Collector.AddReferencedObjects(ClassReleasedTypes.Value);
+	}
+}
@@ -6,11 +6,19 @@
 
 // UInventoryStackItemType
 
+void UInventoryStackItemType::RefreshTypeTraits()
+{
+	Super::RefreshTypeTraits();
+
+	TypeTraits.MaxStackSize = MaxStackSize;
+	TypeTraits.bDirectStackData = true;
+}
+
 bool UInventoryStackItemType::NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess)
 {
 	Super::NetSerialize(Ar, PackageMap, bOutSuccess);
 
-	Ar << MaxStackSize;
+	FInventoryNetQuantization::SerializePackedInt(Ar, MaxStackSize);
 	
 	bOutSuccess = true;
 	return true;
@@ -21,16 +29,11 @@ UScriptStruct* UInventoryStackItemType::GetItemDataType() const
 	return FInventoryStackData::StaticStruct();
 }
 
-TSharedPtr<FInventoryItemDataBase> UInventoryStackItemType::CreateItemData() const
-{
-	return MakeShareable(new FInventoryStackData());
-}
-
-int32 UInventoryStackItemType::AddToStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const
+int32 UInventoryStackItemType::AddToStack(FInventoryItemDataBase* ItemData, const int32 Count) const
 {
-	const TSharedPtr<FInventoryStackData> StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
+	FInventoryStackData* StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
 
-	if (!StackData.IsValid())
+	if (!StackData)
 	{
 		return 0;
 	}
@@ -38,11 +41,11 @@ int32 UInventoryStackItemType::AddToStack(TWeakPtr<FInventoryItemDataBase> ItemD
 	return FStackItemTypeImplementation::AddToStack(StackData->StackCount, Count, MaxStackSize);
 }
 
-int32 UInventoryStackItemType::RemoveFromStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const
+int32 UInventoryStackItemType::RemoveFromStack(FInventoryItemDataBase* ItemData, const int32 Count) const
 {
-	const TSharedPtr<FInventoryStackData> StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
+	FInventoryStackData* StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
 
-	if (!StackData.IsValid())
+	if (!StackData)
 	{
 		return 0;
 	}
@@ -50,11 +53,11 @@ int32 UInventoryStackItemType::RemoveFromStack(TWeakPtr<FInventoryItemDataBase>
 	return FStackItemTypeImplementation::RemoveFromStack(StackData->StackCount, Count);
 }
 
-void UInventoryStackItemType::SetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const
+void UInventoryStackItemType::SetStackCount(FInventoryItemDataBase* ItemData, const int32 Count) const
 {
-	const TSharedPtr<FInventoryStackData> StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
+	FInventoryStackData* StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
 
-	if (!StackData.IsValid())
+	if (!StackData)
 	{
 		return;
 	}
@@ -63,11 +66,11 @@ void UInventoryStackItemType::SetStackCount(TWeakPtr<FInventoryItemDataBase> Ite
 }
 
 
-int32 UInventoryStackItemType::GetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData) const
+int32 UInventoryStackItemType::GetStackCount(const FInventoryItemDataBase* ItemData) const
 {
-	const TSharedPtr<FInventoryStackData> StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
+	const FInventoryStackData* StackData = ConvertDataChecked<FInventoryStackData>(ItemData);
 
-	if (!StackData.IsValid())
+	if (!StackData)
 	{
 		return 0;
 	}
@@ -0,0 +1,238 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/Persistence/InventoryPersistenceSubsystem.h"
+#include "InventorySystem.h"
+#include "Inventory/InventorySnapshot.h"
+#include "Inventory/Components/InventoryComponent.h"
+#include "Inventory/Persistence/InventoryStorageBackend.h"
+#include "Async/Async.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+
+
+
+namespace
+{
+	// Saved inventories are a whole snapshot compressed at once, prefixed with its uncompressed size
+	constexpr int32 MaxSnapshotSize = 64 * 1024 * 1024;
+
+	bool CompressSnapshot(const TArray<uint8>& SnapshotData, TArray<uint8>& OutSaveData)
+	{
+		int32 UncompressedSize = SnapshotData.Num();
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedSize);
+		OutSaveData.SetNumUninitialized(sizeof(int32) + CompressedSize);
+		FMemory::Memcpy(OutSaveData.GetData(), &UncompressedSize, sizeof(int32));
+
+		if (!FCompression::CompressMemory(NAME_Zlib, OutSaveData.GetData() + sizeof(int32), CompressedSize,
+			SnapshotData.GetData(), UncompressedSize))
+		{
+			UE_LOG(LogInventorySystem, Error, TEXT("Failed to compress inventory snapshot"))
+			return false;
+		}
+
+		OutSaveData.SetNum(sizeof(int32) + CompressedSize, false);
+		return true;
+	}
+
+	bool DecompressSnapshot(const TArray<uint8>& SaveData, TArray<uint8>& OutSnapshotData)
+	{
+		int32 UncompressedSize = 0;
+		if (SaveData.Num() < static_cast<int32>(sizeof(int32)))
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(&UncompressedSize, SaveData.GetData(), sizeof(int32));
+		if (UncompressedSize < 0 || UncompressedSize > MaxSnapshotSize)
+		{
+			UE_LOG(LogInventorySystem, Warning, TEXT("Saved inventory has an invalid size of %d"), UncompressedSize)
+			return false;
+		}
+
+		OutSnapshotData.SetNumUninitialized(UncompressedSize);
+		return FCompression::UncompressMemory(NAME_Zlib, OutSnapshotData.GetData(), UncompressedSize,
+			SaveData.GetData() + sizeof(int32), SaveData.Num() - sizeof(int32));
+	}
+}
+
+
+
+// UInventoryPersistenceSubsystem
+
+// Subsystem overrides
+
+void UInventoryPersistenceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	StorageBackend = MakeShared<FInventoryFileStorageBackend, ESPMode::ThreadSafe>(
+		FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Inventories")));
+}
+
+void UInventoryPersistenceSubsystem::Deinitialize()
+{
+	// Make sure the last saves are stored before shutting down
+	for (TFuture<void>& PendingTask : PendingTasks)
+	{
+		PendingTask.Wait();
+	}
+
+	PendingTasks.Empty();
+
+	PendingLoadTypes.Empty();
+
+	Super::Deinitialize();
+}
+
+
+
+// Storage
+
+void UInventoryPersistenceSubsystem::SetStorageBackend(const TSharedRef<IInventoryStorageBackend, ESPMode::ThreadSafe>& InStorageBackend)
+{
+	// Tasks in progress keep the backend they were started with
+	StorageBackend = InStorageBackend;
+}
+
+
+
+// Saving and loading
+
+void UInventoryPersistenceSubsystem::SaveInventory(const UInventoryComponent* InventoryComponent, const FString& Key,
+	FInventorySaveCompleteDelegate OnComplete)
+{
+	check(InventoryComponent);
+
+	// Capturing and encoding the items is the only part of the save that happens on the game thread
+	FInventorySnapshot::FWriter Writer(InventoryComponent->GetArray());
+	const uint32 SaveNumber = NextSaveNumber++;
+
+	TrackTask(Async(EAsyncExecution::ThreadPool, [Writer = MoveTemp(Writer), Key, SaveNumber, Backend = StorageBackend.ToSharedRef(),
+		State = SharedState, OnComplete = MoveTemp(OnComplete)]() mutable
+	{
+		TArray<uint8> SnapshotData;
+		TArray<uint8> SaveData;
+		Writer.Write(SnapshotData);
+		bool bSuccess = CompressSnapshot(SnapshotData, SaveData);
+
+		if (bSuccess)
+		{
+			// Saves with the same key are stored in order, so an older save never replaces a newer one
+			FScopeLock WriteLock(&State->WriteLock);
+			uint32& WrittenSaveNumber = State->WrittenSaveNumbers.FindOrAdd(Key);
+			bSuccess = SaveNumber > WrittenSaveNumber && Backend->WriteInventory(Key, SaveData);
+
+			if (bSuccess)
+			{
+				WrittenSaveNumber = SaveNumber;
+			}
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [bSuccess, OnComplete = MoveTemp(OnComplete)]()
+		{
+			OnComplete.ExecuteIfBound(bSuccess);
+		});
+	}));
+}
+
+void UInventoryPersistenceSubsystem::LoadInventory(const FString& Key, FInventoryLoadCompleteDelegate OnComplete)
+{
+	TWeakObjectPtr<UInventoryPersistenceSubsystem> WeakThis(this);
+
+	TrackTask(Async(EAsyncExecution::ThreadPool, [WeakThis, Key, Backend = StorageBackend.ToSharedRef(),
+		OnComplete = MoveTemp(OnComplete)]() mutable
+	{
+		TSharedRef<FInventorySnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FInventorySnapshot, ESPMode::ThreadSafe>();
+		TArray<uint8> SaveData;
+		TArray<uint8> SnapshotData;
+		const bool bSuccess = Backend->ReadInventory(Key, SaveData) && DecompressSnapshot(SaveData, SnapshotData) &&
+			Snapshot->Read(MoveTemp(SnapshotData));
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess, Snapshot, OnComplete = MoveTemp(OnComplete)]() mutable
+		{
+			UInventoryPersistenceSubsystem* This = WeakThis.Get();
+			if (!This || !bSuccess)
+			{
+				TArray<FInventoryItem> NoItems;
+				OnComplete.ExecuteIfBound(false, NoItems);
+				return;
+			}
+
+			This->MaterializeLoadedItems(Snapshot, MoveTemp(OnComplete));
+		});
+	}));
+}
+
+void UInventoryPersistenceSubsystem::LoadInventoryInto(UInventoryComponent* InventoryComponent, const FString& Key,
+	FInventorySaveCompleteDelegate OnComplete)
+{
+	check(InventoryComponent);
+
+	TWeakObjectPtr<UInventoryComponent> WeakComponent(InventoryComponent);
+	LoadInventory(Key, FInventoryLoadCompleteDelegate::CreateLambda(
+		[WeakComponent, OnComplete = MoveTemp(OnComplete)](bool bSuccess, TArray<FInventoryItem>& LoadedItems)
+	{
+		UInventoryComponent* Component = WeakComponent.Get();
+		bSuccess = bSuccess && Component;
+
+		if (bSuccess)
+		{
+			Component->ReplaceItems(MoveTemp(LoadedItems));
+		}
+
+		OnComplete.ExecuteIfBound(bSuccess);
+	}));
+}
+
+
+
+// Loading helpers
+
+void UInventoryPersistenceSubsystem::MaterializeLoadedItems(const TSharedRef<FInventorySnapshot, ESPMode::ThreadSafe>& Snapshot,
+	FInventoryLoadCompleteDelegate OnComplete)
+{
+	// Types may need to be loaded, which can only happen here. Everything else happens on a worker again
+	TArray<UInventoryItemTypeBase*> ResolvedTypes;
+	Snapshot->ResolveTypes(ResolvedTypes);
+	PendingLoadTypes.Append(ResolvedTypes);
+
+	TWeakObjectPtr<UInventoryPersistenceSubsystem> WeakThis(this);
+
+	TrackTask(Async(EAsyncExecution::ThreadPool, [WeakThis, Snapshot, ResolvedTypes = MoveTemp(ResolvedTypes),
+		OnComplete = MoveTemp(OnComplete)]() mutable
+	{
+		TArray<FInventoryItem> LoadedItems;
+		Snapshot->MaterializeAll(LoadedItems);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, LoadedItems = MoveTemp(LoadedItems), ResolvedTypes = MoveTemp(ResolvedTypes),
+			OnComplete = MoveTemp(OnComplete)]() mutable
+		{
+			UInventoryPersistenceSubsystem* This = WeakThis.Get();
+			if (!This)
+			{
+				// Nothing kept the item types alive, so the items can't be trusted
+				TArray<FInventoryItem> NoItems;
+				OnComplete.ExecuteIfBound(false, NoItems);
+				return;
+			}
+
+			for (UInventoryItemTypeBase* Type : ResolvedTypes)
+			{
+				This->PendingLoadTypes.RemoveSingleSwap(Type, false);
+			}
+
+			OnComplete.ExecuteIfBound(true, LoadedItems);
+		});
+	}));
+}
+
+void UInventoryPersistenceSubsystem::TrackTask(TFuture<void>&& Task)
+{
+	// Finished tasks don't need to be waited on anymore
+	PendingTasks.RemoveAllSwap([](const TFuture<void>& PendingTask)
+	{
+		return PendingTask.IsReady();
+	});
+
+	PendingTasks.Add(MoveTemp(Task));
+}
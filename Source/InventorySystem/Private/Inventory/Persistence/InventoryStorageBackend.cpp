@@ -0,0 +1,44 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#include "Inventory/Persistence/InventoryStorageBackend.h"
+#include "InventorySystem.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+
+// FInventoryFileStorageBackend
+
+bool FInventoryFileStorageBackend::WriteInventory(const FString& Key, const TArray<uint8>& Data)
+{
+	const FString FilePath = GetFilePath(Key);
+
+	// Write to a temporary file first, so a crash mid-write never leaves a partial save behind
+	const FString TempFilePath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(Data, *TempFilePath))
+	{
+		UE_LOG(LogInventorySystem, Error, TEXT("FInventoryFileStorageBackend failed to write %s"), *TempFilePath)
+		return false;
+	}
+
+	if (!IFileManager::Get().Move(*FilePath, *TempFilePath, true, true))
+	{
+		UE_LOG(LogInventorySystem, Error, TEXT("FInventoryFileStorageBackend failed to replace %s"), *FilePath)
+		IFileManager::Get().Delete(*TempFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FInventoryFileStorageBackend::ReadInventory(const FString& Key, TArray<uint8>& OutData)
+{
+	return FFileHelper::LoadFileToArray(OutData, *GetFilePath(Key), FILEREAD_Silent);
+}
+
+FString FInventoryFileStorageBackend::GetFilePath(const FString& Key) const
+{
+	// Keys come from the game, so make sure they can't escape the directory
+	return FPaths::Combine(Directory, FPaths::MakeValidFileName(Key, TEXT('_')) + TEXT(".inv"));
+}
@@ -1,6 +1,7 @@
 ﻿// Copyright (c) 2020 Spencer Melnick
 
 #include "InventorySystem.h"
+#include "Inventory/ItemTypes/ItemTypePool.h"
 #include "Modules/ModuleManager.h"
 #include "Modules/ModuleInterface.h"
 
@@ -17,6 +18,8 @@ void FInventorySystemModule::StartupModule()
 
 void FInventorySystemModule::ShutdownModule()
 {
+	FInventoryItemTypePool::Shutdown();
+
 	UE_LOG(LogInventorySystem, Display, TEXT("InventorySystem: Module Shutdown"));
 }
 
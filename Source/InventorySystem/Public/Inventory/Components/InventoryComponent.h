@@ -5,6 +5,9 @@
 #include "CoreMinimal.h"
 #include "Inventory/InventoryItem.h"
 #include "Inventory/InventoryArray.h"
+#include "Inventory/InventorySortIndex.h"
+#include "Inventory/InventorySummary.h"
+#include "GameplayPrediction.h"
 #include "InventoryComponent.generated.h"
 
 
@@ -12,6 +15,7 @@
 // Delegates
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FInventoryChangedDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FInventoryItemChangedDelegate, int32, ItemID);
 
 
 
@@ -32,18 +36,24 @@ public:
 	// Type aliases
 
 	using FAdditionResult = TPair<int32, FInventoryArrayHandle>;
+	using FRemovalRequest = TPair<UInventoryItemTypeBase*, int32>;
 
 
 	// Engine overrides
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 
 	// Inventory access
 
 	/**
-	 * Try to add an inventory item to this inventory via a copy.
-	 * @return The count of the items added on success or 0 on failure, and a handle to the new item (if any)
+	 * Try to add an inventory item to this inventory via a copy. Only as many items as fit within the weight and slot
+	 * limits are added
+	 * @return The count of the items added on success or 0 on failure, and a handle to the new item, or to the last
+	 * existing stack added to if there is no new item
 	 */
 	TPair<int32, FInventoryArrayHandle> AddItem(const FInventoryItem& NewItem);
 
@@ -55,6 +65,29 @@ public:
 	 */
 	int32 RemoveItem(UInventoryItemTypeBase* ItemType, int32 Count);
 
+	/**
+	 * Try to add several inventory items to this inventory via copies. Existing items are only looked up once per item
+	 * type, and the inventory only replicates and broadcasts its changes once for the whole batch
+	 * @return The result for each entry in the same order, as if AddItem had been called for each entry in turn
+	 */
+	TArray<FAdditionResult> AddItems(TArrayView<const FInventoryItem> NewItems);
+
+	/**
+	 * Try to remove several inventory items from this inventory by type. Existing items are only looked up once per
+	 * item type, and the inventory only replicates and broadcasts its changes once for the whole batch
+	 * @param ItemsToRemove - Pairs of the type of the item to remove and the number of items to be removed
+	 * @return The count of the items removed for each entry in the same order
+	 */
+	TArray<int32> RemoveItems(TArrayView<const FRemovalRequest> ItemsToRemove);
+
+	/**
+	 * Merges partially filled stacks of the same type into as few stacks as possible, in a single pass over the
+	 * inventory. Earlier stacks are filled first, and stacks left empty are removed. Does nothing without authority
+	 * @return The number of stacks removed
+	 */
+	UFUNCTION(BlueprintCallable, Category=Inventory)
+	int32 CompactStacks();
+
 	/**
 	 * Find all inventory items that match a type
 	 * @param ItemType - Pointer to the type object to compare against
@@ -68,6 +101,36 @@ public:
 	 * @return An array of inventory item handles.
 	 */
 	TArray<FInventoryArrayHandle> GetAllItemsByType(UInventoryItemTypeBase* ItemType);
+
+	/**
+	 * Find all inventory items that match a type, appending them to an existing array so that callers can avoid heap
+	 * allocations by supplying an array with an inline allocator
+	 * @param ItemType - Pointer to the type object to compare against
+	 * @param OutItems - Array to append the inventory item handles to
+	 */
+	template <typename AllocatorType>
+	void GetAllItemsByType(UInventoryItemTypeBase* ItemType, TArray<FInventoryArrayHandle, AllocatorType>& OutItems)
+	{
+		if (!ItemType)
+		{
+			return;
+		}
+
+		if (!ItemType->GetTypeTraits().bAllowsDuplicates)
+		{
+			// Find only the first result if the item type doesn't allow duplicates
+			const FInventoryArrayHandle SingleResult = GetFirstItemByType(ItemType);
+
+			if (!SingleResult.IsNull())
+			{
+				OutItems.Add(SingleResult);
+			}
+
+			return;
+		}
+
+		InventoryArray.FindAllByType(ItemType, OutItems);
+	}
 	
 	/**
 	 * Find the first inventory item that matches a type
@@ -84,7 +147,41 @@ public:
 	FInventoryArrayHandle GetFirstItemByType(UInventoryItemTypeBase* ItemType);
 
 	/**
-	 * Access the underlying array object
+	 * Find all inventory items with gameplay tags that match a query
+	 * @param Query - Tag query to evaluate against each item's gameplay tags
+	 * @return An array of inventory item handles
+	 */
+	TArray<FInventoryArrayHandle> GetAllItemsByTagQuery(const FGameplayTagQuery& Query);
+
+	/**
+	 * Find all inventory items with gameplay tags that match a query
+	 * @param Query - Tag query to evaluate against each item's gameplay tags
+	 * @return An array of temporary inventory item pointers
+	 */
+	TArray<FInventoryItem*> GetAllItemsByTagQueryTemporary(const FGameplayTagQuery& Query);
+
+	/**
+	 * Find all inventory items that have a gameplay tag
+	 * @param Tag - Tag to look for. Items with a child of this tag will also match
+	 * @return An array of inventory item handles
+	 */
+	TArray<FInventoryArrayHandle> GetAllItemsByTag(const FGameplayTag& Tag);
+
+	/**
+	 * Find an inventory item by its unique ID, as passed to the per-item delegates
+	 * @return Handle to the item (handle will be invalid if no item has the ID)
+	 */
+	FInventoryArrayHandle GetItemByID(int32 ItemID) { return InventoryArray.GetHandle(ItemID); }
+
+	/**
+	 * Find an inventory item by its replication ID, which is the same on the server and the owning client
+	 * @return Handle to the item (handle will be invalid if no item has the ID, or it hasn't replicated yet)
+	 */
+	FInventoryArrayHandle GetItemByReplicationID(int32 ReplicationID) { return InventoryArray.GetHandleByReplicationID(ReplicationID); }
+
+	/**
+	 * Access the underlying array object. Items predicted by the owning client aren't in it until the server adds them,
+	 * so use the handle functions to see those as well
 	 */
 	const TArray<FInventoryItem>& GetArray() const { return InventoryArray.GetArray(); }
 
@@ -93,6 +190,187 @@ public:
 	 */
 	TArray<FInventoryArrayHandle> GetArrayHandles() { return InventoryArray.GetArrayHandles(); }
 
+	/**
+	 * Calls the visitor with a handle to each item in the underlying array, in order, without allocating. The visitor
+	 * returns false to stop early, and must not add or remove items
+	 */
+	void ForEachItemHandle(TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor) { InventoryArray.ForEachHandle(Visitor); }
+
+	/**
+	 * Returns an immutable snapshot of the items that can be read from any thread, such as by analytics or audits,
+	 * without blocking changes to the inventory. Unchanged parts of the inventory are shared between snapshots
+	 */
+	TSharedRef<const FInventoryReadSnapshot, ESPMode::ThreadSafe> GetReadSnapshot() { return InventoryArray.GetReadSnapshot(); }
+
+
+	// Sorted views
+
+	/**
+	 * Returns the unique IDs of all items in the specified order. Sort keys are computed once per item change, and the
+	 * order is maintained incrementally after the first request, so repeated calls are cheap
+	 */
+	const TArray<int32>& GetSortedItemIDs(const EInventorySortMode SortMode);
+
+	/**
+	 * Finds the unique IDs of all items whose display names contain the search text, ignoring case
+	 * @param SearchText - Text to search for
+	 * @param SortMode - Order of the results
+	 */
+	UFUNCTION(BlueprintCallable, Category=Inventory)
+	TArray<int32> SearchItemsByName(const FString& SearchText, EInventorySortMode SortMode);
+
+
+	// Summary
+
+	/**
+	 * Returns the summary of the inventory that is replicated to clients other than the owner. Only the owner receives
+	 * the full item array, so other clients should use this instead
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	const FInventorySummary& GetSummary() const { return InventorySummary; }
+
+
+	// Aggregates
+
+	/**
+	 * Returns the total weight of the items, as declared per item by their types
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	float GetTotalWeight() const { return static_cast<float>(InventoryArray.GetAggregates().Weight); }
+
+	/**
+	 * Returns the total value of the items, as declared per item by their types
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	float GetTotalValue() const { return static_cast<float>(InventoryArray.GetAggregates().Value); }
+
+	/**
+	 * Returns the number of slots taken up by the items, as declared per item or stack by their types
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	int32 GetUsedSlots() const { return InventoryArray.GetAggregates().Slots; }
+
+	/**
+	 * Returns how many items of a type could be added before reaching the weight limit, without accounting for stack
+	 * sizes or slots. Only reads the running totals
+	 */
+	int32 GetCountWithinWeightLimit(const UInventoryItemTypeBase* ItemType) const;
+
+
+	// Pagination
+
+	/**
+	 * Sets the pages whose items are replicated to the owning client in full, when ReplicationPageSize is set. Items in
+	 * other pages are replicated as placeholders. Can be called on either the client or the server, and only takes
+	 * effect on the server
+	 */
+	UFUNCTION(BlueprintCallable, Category=Inventory)
+	void SubscribeToPages(const TArray<int32>& Pages);
+
+	int32 GetReplicationPageSize() const { return ReplicationPageSize; }
+
+	/**
+	 * Returns the page an item is replicated in, to find the pages to subscribe to for a set of displayed items
+	 * @return The page, or INDEX_NONE if the inventory isn't paginated
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	int32 GetItemReplicationPage(int32 ItemID) const { return InventoryArray.GetReplicationPage(ItemID); }
+
+	/**
+	 * Returns the item count and checksum of every page, including pages that aren't subscribed
+	 */
+	UFUNCTION(BlueprintPure, Category=Inventory)
+	const TArray<FInventoryPageSummary>& GetPageSummaries() const { return PageSummaries; }
+
+
+	// Persistence
+
+	/**
+	 * Writes the items to a compact binary snapshot, see FInventorySnapshot
+	 */
+	void SaveSnapshot(TArray<uint8>& OutData) const;
+
+	/**
+	 * Replaces the items with the contents of a snapshot written by SaveSnapshot
+	 * @return False if the data couldn't be read, in which case the inventory is left unchanged
+	 */
+	bool LoadSnapshot(TArray<uint8>&& Data);
+
+	/**
+	 * Replaces the items in a single batch, such as with items loaded by UInventoryPersistenceSubsystem
+	 */
+	void ReplaceItems(TArray<FInventoryItem>&& NewItems) { InventoryArray.ReplaceItems(MoveTemp(NewItems)); }
+
+
+	// Prediction
+
+	/**
+	 * Try to add an inventory item ahead of the server on the owning client, tied to a prediction key such as the
+	 * activation key of a locally predicted ability. The addition is undone if the key is rejected, and replaced by the
+	 * server's items once the server acknowledges the key. On the server this adds the item normally and acknowledges
+	 * the key to the owning client, so both sides should call this with the same key
+	 * @return The count of the items added on success or 0 on failure, and a handle to the item added to, as with AddItem
+	 */
+	FAdditionResult PredictAddItem(const FInventoryItem& NewItem, const FPredictionKey& PredictionKey);
+
+	/**
+	 * Try to remove an inventory item ahead of the server on the owning client, in the same way as PredictAddItem.
+	 * Clients only predict removals from stackable types, and stacks they empty are kept with a count of 0 until the
+	 * server's items arrive
+	 * @return The count of the items removed or 0 if none were removed
+	 */
+	int32 PredictRemoveItem(UInventoryItemTypeBase* ItemType, int32 Count, const FPredictionKey& PredictionKey);
+
+	/**
+	 * Returns true if the inventory holds changes predicted by this client that the server hasn't acknowledged yet
+	 */
+	bool HasPredictedChanges() const { return PredictedOperations.Num() > 0; }
+
+
+	// Editor properties
+
+	// Stacks are automatically compacted whenever an addition leaves the inventory with more than this many items
+	// A value of 0 disables compaction on additions
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Inventory, meta=(ClampMin=0))
+	int32 CompactionItemBudget = 0;
+
+	// Interval in seconds between automatic stack compactions on the server. A value of 0 disables the timer
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Inventory, meta=(ClampMin=0))
+	float CompactionInterval = 0.f;
+
+	// Maximum total weight of the items. Additions that would exceed it are reduced or rejected. A value of 0 disables
+	// the limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Inventory, meta=(ClampMin=0))
+	float MaxWeight = 0.f;
+
+	// Maximum number of slots the items can take up. Additions that need a new item past it are reduced to what fits in
+	// existing stacks. A value of 0 disables the limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Inventory, meta=(ClampMin=0))
+	int32 MaxSlots = 0;
+
+	// Items matching this query are included in the summary replicated to clients other than the owner
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Inventory)
+	FGameplayTagQuery SummaryItemQuery;
+
+	// Maximum number of visible items included in the summary
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Inventory, meta=(ClampMin=0))
+	int32 MaxSummaryItems = 8;
+
+	// Number of item slots per replication page. When set, only the pages the owner subscribes to are replicated in full,
+	// and other items are sent as placeholders with just their type and stack count, which keeps very large inventories
+	// cheap until they're opened. A value of 0 replicates every item in full
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Inventory, meta=(ClampMin=0))
+	int32 ReplicationPageSize = 0;
+
+	// Number of newly subscribed pages that start replicating with each net update
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Inventory, meta=(ClampMin=1))
+	int32 PagesStreamedPerUpdate = 1;
+
+	// Seconds to wait for the server to acknowledge a predicted change after its prediction key has caught up, before
+	// the change is undone. Covers predictions the server never ran, such as interactions it found out of range
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Inventory, meta=(ClampMin=0))
+	float PredictionTimeout = 1.f;
+
 
 	// Delegates
 
@@ -101,13 +379,137 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FInventoryChangedDelegate OnInventoryChanged;
 
+	// Called with the unique ID of each item added to the inventory. Fires before OnInventoryChanged
+	UPROPERTY(BlueprintAssignable)
+	FInventoryItemChangedDelegate OnItemAdded;
+
+	// Called with the unique ID of each item modified in the inventory. Fires before OnInventoryChanged
+	UPROPERTY(BlueprintAssignable)
+	FInventoryItemChangedDelegate OnItemChanged;
+
+	// Called with the unique ID of each item about to be removed from the inventory, while it can still be accessed
+	UPROPERTY(BlueprintAssignable)
+	FInventoryItemChangedDelegate OnItemRemoved;
+
+	// Called on clients other than the owner when the replicated summary changes
+	UPROPERTY(BlueprintAssignable)
+	FInventoryChangedDelegate OnSummaryChanged;
+
+	// Called on the owning client when the page summaries change
+	UPROPERTY(BlueprintAssignable)
+	FInventoryChangedDelegate OnPageSummariesChanged;
+
 
 
 protected:
 
+	// Inventory access helpers
+
+	/**
+	 * Adds an item, stacking onto the existing items of the same type first. The handle to any new item is appended
+	 * to the existing items
+	 * @return The count of the items added, and a handle to the new item or else the last existing stack added to
+	 */
+	FAdditionResult AddItemToExisting(const FInventoryItem& NewItem, FInventoryInlineHandleArray& ExistingItems);
+
+	/**
+	 * Removes items from the existing items of the same type. Handles to removed items are dropped from the existing
+	 * items, but empty stacks are left in the inventory until RemoveEmptyStacks is called
+	 * @return The count of the items removed
+	 */
+	int32 RemoveItemFromExisting(UInventoryItemTypeBase* ItemType, const int32 Count, FInventoryInlineHandleArray& ExistingItems);
+
+	void RemoveEmptyStacks();
+
+	/**
+	 * Compacts stacks if the inventory holds more items than the compaction budget allows
+	 */
+	void CompactStacksIfOverBudget();
+
+	void OnCompactionTimer();
+
+	/**
+	 * Updates the replicated summary from the current items, only looking for visible items again if one of them may
+	 * have changed. Only has an effect on the server
+	 */
+	void UpdateSummary();
+
+	/**
+	 * Flags the visible items of the summary to be found again if a change to the item could affect them
+	 */
+	void MarkSummaryItemsDirty(const int32 ItemID, const bool bRemoved);
+
+	/**
+	 * Recomputes the replicated summaries of any changed pages. Only has an effect on the server
+	 */
+	void UpdatePageSummaries();
+
+	/**
+	 * Builds the sort index from the replicated items and any predicted ones
+	 */
+	void BuildSortIndex();
+
+
+	// Prediction helpers
+
+	/**
+	 * Local changes made to the inventory under a single prediction key
+	 */
+	struct FPredictedOperation
+	{
+		FPredictionKey::KeyType PredictionKey = 0;
+
+		// Unique IDs of existing stacks and the count each was changed by
+		TArray<TPair<int32, int32>, TInlineAllocator<4>> StackChanges;
+
+		// Unique IDs of items that only exist on this client
+		TArray<int32, TInlineAllocator<2>> CreatedItemIDs;
+
+		// World time the prediction key caught up at, or a negative value if it hasn't yet
+		float CaughtUpTime = -1.f;
+	};
+
+	/**
+	 * Records the changes made to the items of a type since their stack counts were captured, and starts listening for
+	 * the prediction key to be rejected or caught up
+	 */
+	void RecordPredictedOperation(const FPredictionKey& PredictionKey, const TMap<int32, int32>& PreviousStackCounts, const FInventoryInlineHandleArray& CurrentItems);
+
+	/**
+	 * Undoes the changes of a predicted operation that haven't already been replaced by replicated changes
+	 */
+	void RevertPredictedOperation(const FPredictedOperation& Operation);
+
+	/**
+	 * Reverts and forgets every predicted operation that matches a predicate
+	 */
+	void ResolvePredictedOperations(TFunctionRef<bool(const FPredictedOperation&)> Predicate);
+
+	/**
+	 * Forgets any predicted changes to an item, once replication has replaced them with the server's state
+	 */
+	void DiscardPredictedChanges(const int32 ItemID);
+
+	/**
+	 * Tells the owning client that the server has applied the changes for a prediction key. Only the most recent keys
+	 * are kept, so a key that drops out before the client sees it is resolved once it catches up instead
+	 */
+	void AcknowledgePrediction(const FPredictionKey& PredictionKey);
+
+	void OnPredictionRejected(FPredictionKey::KeyType PredictionKey);
+	void OnPredictionCaughtUp(FPredictionKey::KeyType PredictionKey);
+	void OnPredictionTimeout();
+
+
 	// Delegate functions
 
 	void OnInventoryArrayChanged();
+	void OnInventoryArrayItemAdded(int32 ItemID);
+	void OnInventoryArrayItemChanged(int32 ItemID);
+	void OnInventoryArrayItemRemoved(int32 ItemID);
+	void OnInventoryArrayReplicationDirty();
+	void OnInventoryArrayItemIDsReassigned();
+	void OnInventoryArrayResyncRequested();
 	
 
 	// Replication
@@ -115,6 +517,21 @@ protected:
 	UFUNCTION()
 	virtual void OnRep_InventoryArray();
 
+	UFUNCTION()
+	virtual void OnRep_InventorySummary();
+
+	UFUNCTION()
+	virtual void OnRep_PageSummaries();
+
+	UFUNCTION()
+	virtual void OnRep_AcknowledgedPredictionKeys();
+
+	UFUNCTION(Server, Reliable)
+	void ServerSubscribeToPages(const TArray<int32>& Pages);
+
+	UFUNCTION(Server, Reliable)
+	void ServerResyncItems(const TArray<int32>& ReplicationIDs);
+
 
 	// Delegates
 
@@ -122,6 +539,36 @@ protected:
 	
 
 private:
+	// Only replicated to the owner
 	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_InventoryArray)
 	FInventoryArray InventoryArray;
+
+	// Replicated to everyone but the owner
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing=OnRep_InventorySummary)
+	FInventorySummary InventorySummary;
+
+	// Only replicated to the owner, and only used when the inventory is paginated
+	UPROPERTY(ReplicatedUsing=OnRep_PageSummaries)
+	TArray<FInventoryPageSummary> PageSummaries;
+
+	// Only replicated to the owner. The most recent prediction keys the server applied inventory changes for, which
+	// replicate along with the item changes themselves. Keys aren't applied in order, so each one is acknowledged on its own
+	UPROPERTY(ReplicatedUsing=OnRep_AcknowledgedPredictionKeys)
+	TArray<int32> AcknowledgedPredictionKeys;
+
+	FTimerHandle CompactionTimerHandle;
+
+	// Pages last requested through SubscribeToPages, so repeated requests don't send anything
+	TArray<int32> RequestedPages;
+	FTimerHandle PredictionTimeoutHandle;
+
+	// Changes predicted by the owning client, in the order they were made
+	TArray<FPredictedOperation> PredictedOperations;
+
+	// Built the first time a sorted view or search is requested, and updated from the item delegates after that
+	FInventorySortIndex SortIndex;
+
+	// Unique IDs of the items in the summary in slot order, and whether they need to be found again
+	TArray<int32> SummaryItemIDs;
+	bool bSummaryItemsDirty = true;
 };
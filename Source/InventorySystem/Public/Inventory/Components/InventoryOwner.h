@@ -9,8 +9,10 @@
 // Forward declarations
 
 class UInventoryComponent;
+class UInventoryItemTypeBase;
 struct FInventoryItem;
 struct FInventoryArrayHandle;
+struct FPredictionKey;
 
 
 UINTERFACE(meta=(CannotImplementInterfaceInBlueprint))
@@ -31,6 +33,7 @@ public:
 	// Type aliases
 
 	using FAdditionResult = TPair<int32, FInventoryArrayHandle>;
+	using FRemovalRequest = TPair<UInventoryItemTypeBase*, int32>;
 
 
 	// Interface functions
@@ -40,7 +43,25 @@ public:
 
 	/**
 	* Try to add an inventory item to this inventory.
-	* @return The count of the items added on success or 0 on failure, and a handle to the item added (if any)
+	* @return The count of the items added on success or 0 on failure, and a handle to the item added to (if any)
 	*/
 	FAdditionResult AddItem(const FInventoryItem& NewItem);
+
+	/**
+	 * Try to add an inventory item to this inventory ahead of the server, see UInventoryComponent::PredictAddItem
+	 * @return The count of the items added on success or 0 on failure, and a handle to the item added (if any)
+	 */
+	FAdditionResult PredictAddItem(const FInventoryItem& NewItem, const FPredictionKey& PredictionKey);
+
+	/**
+	 * Try to add several inventory items to this inventory at once.
+	 * @return The result of each addition, in the same order as the items
+	 */
+	TArray<FAdditionResult> AddItems(TArrayView<const FInventoryItem> NewItems);
+
+	/**
+	 * Try to remove several inventory items from this inventory by type at once.
+	 * @return The count of the items removed for each entry, in the same order as the entries
+	 */
+	TArray<int32> RemoveItems(TArrayView<const FRemovalRequest> ItemsToRemove);
 };
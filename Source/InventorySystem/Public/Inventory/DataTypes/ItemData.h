@@ -5,6 +5,15 @@
 #include "CoreMinimal.h"
 #include "ItemData.generated.h"
 
+
+
+// Forward declarations
+
+struct FInventoryItemTypeTraits;
+class FProperty;
+
+
+
 /**
  * Base class for item data. Override to add additional item data as needed.
  */
@@ -22,7 +31,50 @@ struct INVENTORYSYSTEM_API FInventoryItemDataBase
 	virtual UScriptStruct* GetScriptStruct() const { return StaticStruct(); }
 
 	/**
-	 * Create a copy of this data, allocated on the heap
+	 * Net serializes the data as part of an inventory item, where both ends know the traits of the item type. By default
+	 * this uses the struct's own NetSerialize if it has one, and otherwise serializes each property with
+	 * NetSerializeProperty
+	 */
+	virtual void NetSerializeForItem(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItemTypeTraits& TypeTraits, bool& bOutSuccess);
+
+	/**
+	 * Net serializes a single property of the data as part of an inventory item. Override to pack fields using limits
+	 * from the item type, such as a stack count bounded by the maximum stack size
+	 * @return True if the property was serialized, or false to use the property's default net serialization
+	 */
+	virtual bool NetSerializeProperty(FArchive& Ar, UPackageMap* PackageMap, const FProperty* Property, void* Value,
+		const FInventoryItemTypeTraits& TypeTraits) { return false; }
+};
+
+
+
+/**
+ * Helpers for packing the integer fields of item data into as few bits as possible
+ */
+struct INVENTORYSYSTEM_API FInventoryNetQuantization
+{
+	/**
+	 * Serializes a value that is expected to be within [0, MaxValue] with only as many bits as MaxValue needs. Values
+	 * outside of the range cost one extra bit and fall back to the variable length encoding, so they still arrive intact
+	 */
+	static void SerializeBoundedInt(FArchive& Ar, int32& Value, const int32 MaxValue);
+
+	/**
+	 * Serializes a value with a variable length encoding, so that values close to zero take fewer bits
 	 */
-	virtual FInventoryItemDataBase* Copy() const;
+	static void SerializePackedInt(FArchive& Ar, int32& Value);
+
+	/**
+	 * Serializes a real value as a packed count of 1 / Scale steps. The loaded value is exactly what QuantizeFixedPoint
+	 * returns for the saved value
+	 */
+	static void SerializeFixedPoint(FArchive& Ar, float& Value, const int32 Scale);
+
+	/**
+	 * Rounds a real value to the precision SerializeFixedPoint sends it with
+	 */
+	static float QuantizeFixedPoint(const float Value, const int32 Scale);
+
+	// Steps per unit that the weight and value of item types are sent with
+	static constexpr int32 ContributionScale = 100;
 };
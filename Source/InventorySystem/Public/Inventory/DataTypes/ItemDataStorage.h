@@ -0,0 +1,125 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+// Item data structs up to this size (in bytes) are stored inside the inventory item instead of on the heap
+// Can be overridden from the module build rules
+#ifndef INVENTORY_ITEM_DATA_INLINE_SIZE
+	#define INVENTORY_ITEM_DATA_INLINE_SIZE 32
+#endif
+
+
+
+// Forward declarations
+
+struct FInventoryItemDataBase;
+
+
+
+/**
+ * Owning storage for polymorphic item data. Small data structs are constructed directly inside the storage, so that
+ * items in an inventory array keep their data in the same allocation as the array, and only data structs larger than
+ * the inline buffer fall back to a heap allocation. Construction, copying, and destruction all go through the data
+ * struct's reflection data, so any USTRUCT derived from FInventoryItemDataBase can be stored.
+ *
+ * Heap allocated data is reference counted and shared between copies of the storage until one of them asks for
+ * mutable access, at which point that copy detaches with its own allocation (copy-on-write). Inline data is always
+ * copied, since copying it never allocates.
+ */
+class INVENTORYSYSTEM_API FInventoryItemDataStorage
+{
+public:
+	static constexpr int32 InlineSize = INVENTORY_ITEM_DATA_INLINE_SIZE;
+	static constexpr int32 InlineAlignment = 16;
+
+
+	FInventoryItemDataStorage() {}
+
+	FInventoryItemDataStorage(const FInventoryItemDataStorage& Other);
+	FInventoryItemDataStorage(FInventoryItemDataStorage&& Other) noexcept;
+	FInventoryItemDataStorage& operator=(const FInventoryItemDataStorage& Other);
+	FInventoryItemDataStorage& operator=(FInventoryItemDataStorage&& Other) noexcept;
+
+	~FInventoryItemDataStorage()
+	{
+		Reset();
+	}
+
+
+	// Storage control
+
+	/**
+	 * Destroys any current data and default constructs new data of the specified type
+	 * @param InScriptStruct - Type of the new data. Must be derived from FInventoryItemDataBase, or null to just reset
+	 */
+	void Initialize(UScriptStruct* InScriptStruct);
+
+	/**
+	 * Destroys the current data, if any
+	 */
+	void Reset();
+
+
+	// Accessors
+
+	bool IsValid() const { return ScriptStruct != nullptr; }
+	bool IsInline() const { return ScriptStruct && CanStoreInline(ScriptStruct); }
+	UScriptStruct* GetScriptStruct() const { return ScriptStruct; }
+
+	/**
+	 * Checks if the data is currently shared with another copy of the storage
+	 */
+	bool IsShared() const;
+
+	/**
+	 * Read only access to the data. Never copies shared data
+	 */
+	const FInventoryItemDataBase* Get() const { return static_cast<const FInventoryItemDataBase*>(GetMemory()); }
+	const FInventoryItemDataBase* operator->() const { return Get(); }
+
+	/**
+	 * Mutable access to the data. Detaches from any other copies first, so this may allocate
+	 */
+	FInventoryItemDataBase* GetMutable();
+
+	/**
+	 * Checks if data of a specific type would fit in the inline buffer
+	 */
+	static bool CanStoreInline(const UScriptStruct* InScriptStruct);
+
+
+private:
+
+	// Helper functions
+
+	const void* GetMemory() const;
+	void CopyFrom(const FInventoryItemDataStorage& Other);
+	void MoveFrom(FInventoryItemDataStorage& Other);
+
+	/**
+	 * Allocates a heap block with a single reference and uninitialized data
+	 */
+	static uint8* AllocateHeapBlock(const UScriptStruct* InScriptStruct);
+
+	/**
+	 * Drops a reference to a heap block, destroying the data and freeing the block if it was the last reference
+	 */
+	static void ReleaseHeapBlock(uint8* Block, const UScriptStruct* InScriptStruct);
+
+	static FThreadSafeCounter& GetHeapReferenceCount(uint8* Block) { return *reinterpret_cast<FThreadSafeCounter*>(Block); }
+	static int32 GetHeapDataOffset(const UScriptStruct* InScriptStruct);
+
+
+	UScriptStruct* ScriptStruct = nullptr;
+
+	// Heap blocks start with a reference count, followed by the data at the struct's alignment
+	union
+	{
+		TAlignedBytes<InlineSize, InlineAlignment> InlineData;
+		uint8* HeapBlock;
+	};
+};
@@ -19,6 +19,12 @@ struct INVENTORYSYSTEM_API FInventoryStackData : public FInventoryItemDataBase
 	GENERATED_BODY()
 
 	virtual UScriptStruct* GetScriptStruct() const override { return StaticStruct(); }
+
+	// The stack count is bounded by the maximum stack size when replicated as part of an item
+	virtual void NetSerializeForItem(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItemTypeTraits& TypeTraits, bool& bOutSuccess) override;
+	virtual bool NetSerializeProperty(FArchive& Ar, UPackageMap* PackageMap, const FProperty* Property, void* Value,
+		const FInventoryItemTypeTraits& TypeTraits) override;
+
 	bool NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess);
 
 	UPROPERTY(EditAnywhere)
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "Inventory/InventoryItem.h"
+#include "Inventory/InventoryReadSnapshot.h"
+#include "Inventory/InventoryTagIndex.h"
+#include "Inventory/InventorySummary.h"
 #include "InventoryArray.generated.h"
 
 
@@ -14,10 +17,53 @@ struct FInventoryArray;
 
 
 
+/**
+ * Validity flag owned by a single inventory array and shared with the handles that cached a lookup into it. The flag
+ * is cleared when the array is destroyed or invalidates its handles, and copies of an array always get their own
+ * flag, so destroying one array never affects the cached lookups of another
+ */
+struct FInventoryArrayHandleToken
+{
+	FInventoryArrayHandleToken()
+		: Flag(MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(true))
+	{};
+
+	FInventoryArrayHandleToken(const FInventoryArrayHandleToken& Other)
+		: FInventoryArrayHandleToken()
+	{};
+
+	FInventoryArrayHandleToken& operator=(const FInventoryArrayHandleToken& Other)
+	{
+		// The array's contents are being replaced, so lookups cached against the old contents are stale
+		Invalidate();
+		return *this;
+	}
+
+	~FInventoryArrayHandleToken()
+	{
+		*Flag = false;
+	}
+
+	/**
+	 * Clears the flag shared with existing handles, and starts a new one for future lookups
+	 */
+	void Invalidate()
+	{
+		*Flag = false;
+		Flag = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(true);
+	}
+
+	TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Flag;
+};
+
+
+
 /**
  * Handle to a specific item in an inventory item array, that allows for fast removal and handles marking the array
  * as dirty when needed. Functions like a weak reference in that it doesn't prevent destruction of the item. It works
  * by maintaining a pointer to the inventory array and a unique ID that can be referenced to find the item in the array.
+ * The unique ID packs a slot index and slot generation, so lookups are a single array access and a handle to a removed
+ * item will never resolve to a different item that reused its slot.
  * Furthermore, the array validity is checked by maintaining a weak object pointer to the owning object of the array (so
  * that theoretically when the owner is invalidated or garbage collected, we know the array is also invalid)
  */
@@ -35,7 +81,8 @@ public:
 	{};
 
 	FInventoryArrayHandle(const FInventoryArrayHandle& Other)
-		: ItemID(Other.ItemID), ArrayOwner(Other.ArrayOwner), Array(Other.Array)
+		: ItemID(Other.ItemID), ArrayOwner(Other.ArrayOwner), Array(Other.Array),
+		CachedIndex(Other.CachedIndex), CachedRevision(Other.CachedRevision), CachedToken(Other.CachedToken)
 	{};
 
 	FInventoryArrayHandle& operator=(const FInventoryArrayHandle& Other)
@@ -43,6 +90,9 @@ public:
 		ItemID = Other.ItemID;
 		ArrayOwner = Other.ArrayOwner;
 		Array = Other.Array;
+		CachedIndex = Other.CachedIndex;
+		CachedRevision = Other.CachedRevision;
+		CachedToken = Other.CachedToken;
 		return *this;
 	}
 
@@ -71,7 +121,16 @@ public:
 	}
 
 	/**
-	 * Returns the underlying inventory item's array index, or INDEX_NONE if the handle is invalid
+	 * Returns the unique ID of the referenced item with no checks
+	 */
+	int32 GetItemID() const
+	{
+		return ItemID;
+	}
+
+	/**
+	 * Returns the underlying inventory item's array index, or INDEX_NONE if the handle is invalid. The index is cached
+	 * along with the array revision, so repeated lookups while the array is structurally unchanged skip validation
 	 */
 	int32 GetIndex() const;
 
@@ -101,7 +160,7 @@ public:
 	/**
 	 * Clears the state of this inventory item handle so it no longer refers to anything
 	 */
-	void Clear() { ItemID = INDEX_NONE; ArrayOwner = nullptr; Array = nullptr; }
+	void Clear() { ItemID = INDEX_NONE; ArrayOwner = nullptr; Array = nullptr; CachedIndex = INDEX_NONE; CachedToken.Reset(); }
 
 
 protected:
@@ -114,6 +173,217 @@ private:
 	int32 ItemID;
 	TWeakObjectPtr<UObject> ArrayOwner;
 	FInventoryArray* Array;
+
+	// Last resolved index, valid while the array revision is unchanged and the array's token is still set
+	mutable int32 CachedIndex = INDEX_NONE;
+	mutable uint32 CachedRevision = 0;
+	mutable TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> CachedToken;
+};
+
+
+
+/**
+ * Handle array with inline space for a few handles, for query results that are only used temporarily
+ */
+using FInventoryInlineHandleArray = TArray<FInventoryArrayHandle, TInlineAllocator<8>>;
+
+
+
+/**
+ * Lazily filtered view of the items in an inventory array, followed by its predicted items. Items are tested against the
+ * predicate while iterating, so no results are allocated. Like temporary pointers, the view must not be used after items
+ * are added or removed
+ */
+template <class PredicateClass>
+class TInventoryFilteredRange
+{
+public:
+	class FIterator
+	{
+	public:
+		FIterator(TArray<FInventoryItem>& InItems, TArray<FInventoryItem>& InPredictedItems, const PredicateClass& InPredicate,
+			const int32 InIndex)
+			: Items(InItems), PredictedItems(InPredictedItems), Predicate(InPredicate), Index(InIndex)
+		{
+			SkipRejected();
+		}
+
+		FIterator& operator++()
+		{
+			Index++;
+			SkipRejected();
+			return *this;
+		}
+
+		FInventoryItem& operator*() const { return GetItem(); }
+		FInventoryItem* operator->() const { return &GetItem(); }
+		bool operator!=(const FIterator& Other) const { return Index != Other.Index; }
+
+	private:
+		FInventoryItem& GetItem() const
+		{
+			return Index < Items.Num() ? Items[Index] : PredictedItems[Index - Items.Num()];
+		}
+
+		void SkipRejected()
+		{
+			while (Index < Items.Num() + PredictedItems.Num() && !Predicate(GetItem()))
+			{
+				Index++;
+			}
+		}
+
+		TArray<FInventoryItem>& Items;
+		TArray<FInventoryItem>& PredictedItems;
+		const PredicateClass& Predicate;
+		int32 Index;
+	};
+
+	TInventoryFilteredRange(TArray<FInventoryItem>& InItems, TArray<FInventoryItem>& InPredictedItems, PredicateClass InPredicate)
+		: Items(InItems), PredictedItems(InPredictedItems), Predicate(MoveTemp(InPredicate))
+	{}
+
+	FIterator begin() { return FIterator(Items, PredictedItems, Predicate, 0); }
+	FIterator end() { return FIterator(Items, PredictedItems, Predicate, Items.Num() + PredictedItems.Num()); }
+
+private:
+	TArray<FInventoryItem>& Items;
+	TArray<FInventoryItem>& PredictedItems;
+	PredicateClass Predicate;
+};
+
+
+
+/**
+ * Running totals of the per-item contributions declared by item types. Totals are accumulated in double precision, so
+ * that adding and removing the same items many times doesn't drift
+ */
+struct FInventoryAggregates
+{
+	double Weight = 0.0;
+	double Value = 0.0;
+	int32 Slots = 0;
+
+	FInventoryAggregates& operator+=(const FInventoryAggregates& Other)
+	{
+		Weight += Other.Weight;
+		Value += Other.Value;
+		Slots += Other.Slots;
+		return *this;
+	}
+
+	FInventoryAggregates& operator-=(const FInventoryAggregates& Other)
+	{
+		Weight -= Other.Weight;
+		Value -= Other.Value;
+		Slots -= Other.Slots;
+		return *this;
+	}
+};
+
+
+
+/**
+ * Entry in the slot table of an inventory array. Slots keep a stable index for each item even when the item array is
+ * reordered by swap removals, and the generation is incremented whenever the slot is freed so that stale IDs can be
+ * detected
+ */
+struct FInventoryArraySlot
+{
+	// Index of the item in the item array, or INDEX_NONE if the slot is free
+	int32 ItemIndex = INDEX_NONE;
+
+	// Incremented every time the slot is freed
+	int32 Generation = 0;
+
+	// Type the item was indexed with and its hash at the time, used to detect type changes. The type isn't referenced
+	// by the slot, so it's only ever compared and never dereferenced
+	TWeakObjectPtr<const UInventoryItemTypeBase> IndexedType;
+	uint32 IndexedTypeHash = 0;
+
+	// Type index entry the item was filed under, if any
+	FSetElementId TypeEntryID;
+
+	// What the item currently counts towards the array's aggregates, so it can be taken back out when it changes
+	FInventoryAggregates Contribution;
+
+	// Replication ID the slot is filed under in the array's replication ID map, if any
+	int32 ReplicationID = INDEX_NONE;
+};
+
+
+
+/**
+ * Entry in the type index of an inventory array, holding the IDs of all items with an equivalent type. The hash is
+ * computed once when the entry is created, so the entry can be rehashed or removed even if its type has since been
+ * garbage collected or changed
+ */
+struct FInventoryTypeIndexEntry
+{
+	TWeakObjectPtr<const UInventoryItemTypeBase> Type;
+	uint32 TypeHash = 0;
+	TArray<int32> ItemIDs;
+};
+
+
+
+/**
+ * Key used to look up type index entries, pairing a type with its precomputed hash
+ */
+struct FInventoryTypeIndexKey
+{
+	FInventoryTypeIndexKey(const UInventoryItemTypeBase* InType, const uint32 InHash) :
+		Type(InType), Hash(InHash) {}
+
+	explicit FInventoryTypeIndexKey(const UInventoryItemTypeBase* InType) :
+		Type(InType), Hash(InType ? InType->GetItemTypeHash() : 0) {}
+
+	const UInventoryItemTypeBase* Type;
+	uint32 Hash;
+};
+
+
+
+/**
+ * Key functions that compare item types using their own equality operator instead of the object pointer, so that
+ * separate but equivalent type objects share a type index entry. Entries whose type is gone never match a lookup
+ */
+struct FInventoryTypeIndexKeyFuncs : BaseKeyFuncs<FInventoryTypeIndexEntry, FInventoryTypeIndexKey>
+{
+	typedef FInventoryTypeIndexKey KeyInitType;
+
+	static KeyInitType GetSetKey(ElementInitType Element) { return FInventoryTypeIndexKey(Element.Type.Get(), Element.TypeHash); }
+	static uint32 GetKeyHash(KeyInitType Key) { return Key.Hash; }
+
+	static bool Matches(KeyInitType A, KeyInitType B)
+	{
+		return A.Hash == B.Hash && A.Type && B.Type && (A.Type == B.Type || *A.Type == *B.Type);
+	}
+};
+
+
+
+/**
+ * Replicated state of a dynamic item type (one that isn't supported for networking), made of its class and the bits
+ * written by its NetSerialize. Equal definitions always replicate to equal types, so inventory arrays keep a dictionary
+ * of the definitions each connection has received and only send an ID when a definition is repeated
+ */
+struct INVENTORYSYSTEM_API FInventoryItemTypeDefinition
+{
+	UClass* TypeClass = nullptr;
+	TArray<uint8> Data;
+	int64 NumBits = 0;
+
+	bool operator==(const FInventoryItemTypeDefinition& Other) const
+	{
+		return TypeClass == Other.TypeClass && NumBits == Other.NumBits
+			&& FMemory::Memcmp(Data.GetData(), Other.Data.GetData(), Data.Num()) == 0;
+	}
+
+	friend uint32 GetTypeHash(const FInventoryItemTypeDefinition& Definition)
+	{
+		return HashCombine(PointerHash(Definition.TypeClass), FCrc::MemCrc32(Definition.Data.GetData(), Definition.Data.Num()));
+	}
 };
 
 
@@ -129,11 +399,12 @@ DECLARE_DELEGATE(FInventoryArrayChangedDelegate);
 * Struct that wraps an array of inventory items for use with a fast array serializer
 */
 USTRUCT()
-struct FInventoryArray : public FFastArraySerializer
+struct INVENTORYSYSTEM_API FInventoryArray : public FFastArraySerializer
 {
 	GENERATED_BODY()
 
 	friend struct FInventoryArrayHandle;
+	friend class FInventoryReadSnapshot;
 
 public:
 
@@ -155,6 +426,99 @@ public:
 	void PreReplicatedRemove(const TArrayView<int32>& RemovedIndices, int32 FinalSize);
 	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParams);
 
+	/**
+	 * Returns the state of an item as it was last written to the connection that an inventory array is currently writing
+	 * a replication update for, so the item can write only what changed since. That update may not have arrived yet, so
+	 * the baseline comes with the serial number it was written with for the receiver to check
+	 * @param OutBaselineSerial - Set to the serial number of the baseline state
+	 * @return The item's baseline state, or null if there is no update being written, the connection was never sent the
+	 * item, or the receiver asked for the item to be sent in full
+	 */
+	static const FInventoryItem* GetReplicationBaseline(const int32 ReplicationID, uint32& OutBaselineSerial);
+
+	/**
+	 * Records the state an item is about to be written with during the current replication update, to be used as its
+	 * baseline for the next update to the same connection
+	 * @return The serial number identifying the written state, or 0 if no replication update is being written
+	 */
+	static uint32 RecordReplicatedItem(const FInventoryItem& Item);
+
+	/**
+	 * Maps a dynamic item type definition to its ID in the type dictionary while writing a replication update. IDs are
+	 * assigned once per array and never reused, so a client can keep every definition it receives
+	 * @param ReplicationID - Item being written, which always gets the full definition if the receiver asked for it
+	 * @param bOutConnectionHasDefinition - Set to whether the connection was already sent the definition of the ID
+	 * @return The dictionary ID, or 0 if no replication update is being written
+	 */
+	static uint32 MapReplicatedTypeDefinition(const FInventoryItemTypeDefinition& Definition, const int32 ReplicationID, bool& bOutConnectionHasDefinition);
+
+	/**
+	 * Records that an item read by the array currently reading a replication update now has the type definition with the
+	 * specified dictionary ID, or a type that replicates by reference for an ID of 0
+	 */
+	static void UseReceivedTypeDefinition(const int32 ReplicationID, const uint32 TypeID);
+
+	/**
+	 * Replaces the contribution of an item read by the array currently reading a replication update, after its type was
+	 * changed in place by a received definition
+	 */
+	static void UpdateReceivedTypeContribution(const int32 UniqueID);
+
+	/**
+	 * Checks if the array currently reading a replication update has the state of an item with the specified serial
+	 * number, which a delta must have been written against to be applied
+	 */
+	static bool HasReceivedItemState(const int32 ReplicationID, const uint32 Serial);
+
+	/**
+	 * Remembers the serial number of the state an item was just updated to by the array currently reading a replication
+	 * update
+	 */
+	static void StoreReceivedItemState(const int32 ReplicationID, const uint32 Serial);
+
+	/**
+	 * Asks the server to send an item in full, because the array currently reading a replication update received a
+	 * state it couldn't apply (a delta against a lost state, or a type definition that never arrived)
+	 */
+	static void RequestReplicatedItemResync(const int32 ReplicationID);
+
+	/**
+	 * Stores a type definition received during the current replication update, so later updates can refer to it by ID
+	 */
+	static void StoreReceivedTypeDefinition(const uint32 TypeID, const FInventoryItemTypeDefinition& Definition);
+
+	/**
+	 * Finds a type definition previously received by the array that is currently reading a replication update
+	 * @return The definition, or null if it was never received
+	 */
+	static const FInventoryItemTypeDefinition* FindReceivedTypeDefinition(const uint32 TypeID);
+
+	/**
+	 * Checks if an item written by the array currently writing a replication update is in a page that isn't streamed,
+	 * in which case only a placeholder of it is sent
+	 * @param OutPage - Page of the item, or INDEX_NONE if the array isn't paginated
+	 */
+	static bool ShouldReplicatePlaceholder(const FInventoryItem& Item, int32& OutPage);
+
+
+	// Resynchronization
+
+	/**
+	 * Moves out the replication IDs of items the server needs to send in full, requested while reading replication
+	 * updates, up to MaxResyncRequests at a time. The owner should forward them to the server's ResyncReplicatedItems
+	 */
+	void ConsumeResyncRequests(TArray<int32>& OutReplicationIDs);
+
+	/**
+	 * Makes the next replication update send the specified items in full, including their type definitions, because the
+	 * client couldn't apply what it was sent. Only the first MaxResyncRequests IDs are handled, and items that are
+	 * already waiting to be sent in full or aren't in a streamed page are skipped
+	 */
+	void ResyncReplicatedItems(const TArray<int32>& ReplicationIDs);
+
+	// Most items that can be asked to be sent in full at once
+	static constexpr int32 MaxResyncRequests = 128;
+
 
 	// Array operations
 
@@ -165,13 +529,17 @@ public:
 	template<typename ... ArgsType>
 	FInventoryArrayHandle Emplace(ArgsType&&... Args)
 	{
-		// Create the new item and assign it an ID
-		FInventoryItem& NewItem = Items.Emplace_GetRef(Forward<ArgsType>(Args)...);
-		NewItem.UniqueID = GetNextID();
-		IDtoIndex.Add(NewItem.UniqueID, Items.Num() - 1);
+		// Create the new item and assign it a slot. Items predicted by a client are kept out of the replicated items, so
+		// they never need a replication ID
+		const bool bPredicted = bPredictingChanges;
+		TArray<FInventoryItem>& TargetItems = bPredicted ? PredictedItems : Items;
+		const int32 NewIndex = TargetItems.Emplace(Forward<ArgsType>(Args)...);
+		FInventoryItem& NewItem = TargetItems[NewIndex];
+		AllocateSlot(bPredicted ? NewIndex | PredictedIndexFlag : NewIndex);
 
 		// Update any state
-		MarkItemDirty(NewItem);
+		MarkItemDirtyDeferred(NewItem);
+		NotifyItemAdded(NewItem.UniqueID);
 		NotifyArrayChanged();
 
 		return FInventoryArrayHandle(NewItem.UniqueID, Owner, this);
@@ -183,17 +551,36 @@ public:
 	void MarkDirty(FInventoryArrayHandle& ItemHandle);
 
 	/**
-	 * Removes an element based on its handle
+	 * Removes an element based on its handle. The last element in the array is moved into the removed element's place
 	 */
 	void Remove(FInventoryArrayHandle& ItemHandle);
 
 	/**
-	 * Removes all elements for which the predicate returns true
+	 * Removes all elements for which the predicate returns true, including predicted ones. Does not preserve element order
 	 */
 	template <class PredicateClass>
 	int32 RemoveAll(const PredicateClass& Predicate)
 	{
-		const int32 RemovalCount = Items.RemoveAll(Predicate);
+		int32 RemovalCount = 0;
+
+		// Iterate backwards so that any element swapped into a removed element's place has already been checked
+		for (int32 Index = Items.Num() - 1; Index >= 0; Index--)
+		{
+			if (Predicate(Items[Index]))
+			{
+				RemoveAtSwapInternal(Index);
+				RemovalCount++;
+			}
+		}
+
+		for (int32 Index = PredictedItems.Num() - 1; Index >= 0; Index--)
+		{
+			if (Predicate(PredictedItems[Index]))
+			{
+				RemoveAtSwapInternal(Index | PredictedIndexFlag);
+				RemovalCount++;
+			}
+		}
 
 		if (RemovalCount > 0)
 		{
@@ -209,6 +596,12 @@ public:
 	 */
 	void Empty(int32 Slack = 0);
 
+	/**
+	 * Replaces every element with the new items in a single batch, such as when loading a saved inventory. The old
+	 * items are removed and the new ones are added as if they had been emplaced one at a time
+	 */
+	void ReplaceItems(TArray<FInventoryItem>&& NewItems);
+
 	/**
 	 * Finds all elements for which the predicate returns true
 	 * @return Array of pointers to the elements in the array. Should only be used temporarily - any insertions or
@@ -219,11 +612,14 @@ public:
 	{
 		TArray<FInventoryItem*> Result;
 
-		for (FInventoryItem& Item : Items)
+		for (TArray<FInventoryItem>* ItemList : { &Items, &PredictedItems })
 		{
-			if (Predicate(Item))
+			for (FInventoryItem& Item : *ItemList)
 			{
-				Result.Add(&Item);
+				if (Predicate(Item))
+				{
+					Result.Add(&Item);
+				}
 			}
 		}
 
@@ -238,16 +634,38 @@ public:
 	TArray<FInventoryArrayHandle> FindAll(const PredicateClass& Predicate)
 	{
 		TArray<FInventoryArrayHandle> Result;
+		FindAll(Predicate, Result);
+		return Result;
+	}
 
-		for (FInventoryItem& Item : Items)
+	/**
+	 * Finds all elements for which the predicate returns true, appending handles to an existing array so callers can
+	 * supply an array with an inline allocator
+	 */
+	template <class PredicateClass, typename AllocatorType>
+	void FindAll(const PredicateClass& Predicate, TArray<FInventoryArrayHandle, AllocatorType>& OutHandles)
+	{
+		for (TArray<FInventoryItem>* ItemList : { &Items, &PredictedItems })
 		{
-			if (Predicate(Item))
+			for (FInventoryItem& Item : *ItemList)
 			{
-				Result.Add(FInventoryArrayHandle(Item.UniqueID, Owner, this));
+				if (Predicate(Item))
+				{
+					OutHandles.Add(FInventoryArrayHandle(Item.UniqueID, Owner, this));
+				}
 			}
 		}
+	}
 
-		return Result;
+	/**
+	 * Lazily filters the elements with a predicate, without allocating any results
+	 * @return Range that can be iterated over with a range-based for loop. Should only be used temporarily - any
+	 * insertions or deletions invalidate the range
+	 */
+	template <class PredicateClass>
+	TInventoryFilteredRange<PredicateClass> Filter(PredicateClass Predicate)
+	{
+		return TInventoryFilteredRange<PredicateClass>(Items, PredictedItems, MoveTemp(Predicate));
 	}
 
 	/**
@@ -256,7 +674,11 @@ public:
 	 * could invalidate the pointer
 	 */
 	template <class PredicateClass>
-	FInventoryItem* FindTemporary(const PredicateClass& Predicate) { return (Items.FindByPredicate(Predicate)); }
+	FInventoryItem* FindTemporary(const PredicateClass& Predicate)
+	{
+		FInventoryItem* Item = Items.FindByPredicate(Predicate);
+		return Item ? Item : PredictedItems.FindByPredicate(Predicate);
+	}
 
 	/**
 	 * Finds the first element for which the predicate returns true
@@ -276,15 +698,248 @@ public:
 	}
 
 	/**
-	 * Access the underlying array
+	 * Finds all elements whose type is equal to the specified type, using the type index
+	 * @return Array of pointers to the elements in the array. Should only be used temporarily - any insertions or
+	 * deletions could invalidate the pointers.
+	 */
+	TArray<FInventoryItem*> FindAllByTypeTemporary(const UInventoryItemTypeBase* ItemType);
+
+	/**
+	 * Finds all elements whose type is equal to the specified type, using the type index
+	 * @return Array of handles referencing the elements. Can be stored and referenced later
+	 */
+	TArray<FInventoryArrayHandle> FindAllByType(const UInventoryItemTypeBase* ItemType);
+
+	/**
+	 * Finds all elements whose type is equal to the specified type, using the type index, appending handles to an
+	 * existing array so callers can supply an array with an inline allocator
+	 */
+	template <typename AllocatorType>
+	void FindAllByType(const UInventoryItemTypeBase* ItemType, TArray<FInventoryArrayHandle, AllocatorType>& OutHandles)
+	{
+		const TArray<int32>* ItemIDs = FindIDsByType(ItemType);
+		if (!ItemIDs)
+		{
+			return;
+		}
+
+		OutHandles.Reserve(OutHandles.Num() + ItemIDs->Num());
+		for (const int32 ItemID : *ItemIDs)
+		{
+			OutHandles.Add(FInventoryArrayHandle(ItemID, Owner, this));
+		}
+	}
+
+	/**
+	 * Finds an element whose type is equal to the specified type, using the type index
+	 * @return Pointer to the found element, or null. Should only be used temporarily - insertions or deletions
+	 * could invalidate the pointer
+	 */
+	FInventoryItem* FindByTypeTemporary(const UInventoryItemTypeBase* ItemType);
+
+	/**
+	 * Finds an element whose type is equal to the specified type, using the type index
+	 * @return Handle to the found element. IsNull will be true if no element was found
+	 */
+	FInventoryArrayHandle FindByType(const UInventoryItemTypeBase* ItemType);
+
+	/**
+	 * Finds all elements with gameplay tags that match the query, using the tag index
+	 * @return Array of handles referencing the elements. Can be stored and referenced later
+	 */
+	TArray<FInventoryArrayHandle> FindAllByTagQuery(const FGameplayTagQuery& Query);
+
+	/**
+	 * Finds all elements with gameplay tags that match the query, using the tag index
+	 * @return Array of pointers to the elements in the array. Should only be used temporarily - any insertions or
+	 * deletions could invalidate the pointers.
+	 */
+	TArray<FInventoryItem*> FindAllByTagQueryTemporary(const FGameplayTagQuery& Query);
+
+	/**
+	 * Finds all elements that have the gameplay tag (or one of its children), using the tag index
+	 * @return Array of handles referencing the elements. Can be stored and referenced later
+	 */
+	TArray<FInventoryArrayHandle> FindAllByTag(const FGameplayTag& Tag);
+
+	/**
+	 * Creates a handle to the element with the specified unique ID
+	 * @return Handle to the element. IsNull will be true if no element has the ID
+	 */
+	FInventoryArrayHandle GetHandle(const int32 UniqueID);
+
+	/**
+	 * Creates a handle to the element with the specified replication ID. Unlike unique IDs, replication IDs are the same
+	 * on the server and its clients, so they can be used to refer to items in RPCs
+	 * @return Handle to the element. IsNull will be true if no element has the ID
+	 */
+	FInventoryArrayHandle GetHandleByReplicationID(const int32 InReplicationID);
+
+	/**
+	 * Access the underlying array. Only holds the replicated items, not the ones a client is predicting
 	 */
 	const TArray<FInventoryItem>& GetArray() const { return Items; }
 
 	/**
-	 * Returns handles to all of the items in the underlying array
+	 * Access the items a client has predicted but the server hasn't replicated yet
+	 */
+	const TArray<FInventoryItem>& GetPredictedItems() const { return PredictedItems; }
+
+	/**
+	 * Returns the number of items, including predicted ones
+	 */
+	int32 Num() const { return Items.Num() + PredictedItems.Num(); }
+
+	/**
+	 * Returns handles to all of the items in the underlying array, including predicted ones
 	 */
 	TArray<FInventoryArrayHandle> GetArrayHandles();
 
+	/**
+	 * Appends handles to all of the items in the underlying array to an existing array
+	 */
+	template <typename AllocatorType>
+	void GetArrayHandles(TArray<FInventoryArrayHandle, AllocatorType>& OutHandles)
+	{
+		OutHandles.Reserve(OutHandles.Num() + Num());
+		for (const TArray<FInventoryItem>* ItemList : { &Items, &PredictedItems })
+		{
+			for (const FInventoryItem& Item : *ItemList)
+			{
+				OutHandles.Add(FInventoryArrayHandle(Item.UniqueID, Owner, this));
+			}
+		}
+	}
+
+
+	// Visitors
+
+	/**
+	 * Calls the visitor with a handle to each item in array order, without allocating. The visitor returns false to
+	 * stop early, and must not add or remove items
+	 */
+	void ForEachHandle(TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor);
+
+	/**
+	 * Calls the visitor with a handle to each item whose type is equal to the specified type, using the type index,
+	 * without allocating. The visitor returns false to stop early, and must not add or remove items
+	 */
+	void ForEachHandleByType(const UInventoryItemTypeBase* ItemType, TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor);
+
+	/**
+	 * Calls the visitor with a handle to each item with gameplay tags that match the query, in slot order, using the tag
+	 * index. The visitor returns false to stop early, and must not add or remove items
+	 */
+	void ForEachHandleByTagQuery(const FGameplayTagQuery& Query, TFunctionRef<bool(const FInventoryArrayHandle&)> Visitor);
+
+	/**
+	 * Returns the slot of an item ID, which orders items the same way the tag query visitor does
+	 */
+	static int32 GetItemSlot(const int32 ItemID) { return ItemID == INDEX_NONE ? INDEX_NONE : GetSlotIndex(ItemID); }
+
+	/**
+	 * Forces every handle to this array to fully validate on its next lookup. Should be called when the array's owner is
+	 * destroyed, so that handles with cached lookups notice the owner is gone
+	 */
+	void InvalidateHandles() { HandleToken.Invalidate(); }
+
+
+	// Read snapshots
+
+	/**
+	 * Returns an immutable snapshot of the current items that can be read from any thread. Consecutive calls without
+	 * changes in between return the same snapshot, and after a change only the chunks containing changed slots are
+	 * copied. Must be called on the game thread
+	 */
+	TSharedRef<const FInventoryReadSnapshot, ESPMode::ThreadSafe> GetReadSnapshot();
+
+
+	// Aggregates
+
+	/**
+	 * Returns the total weight, value and slot cost of the items. The totals are updated as each item is added, removed
+	 * or changed, locally or through replication, so reading them never visits the items
+	 */
+	const FInventoryAggregates& GetAggregates() const { return Aggregates; }
+
+
+	// Pagination
+
+	/**
+	 * Splits the array into pages of item slots for replication, so that only the pages a client subscribes to are
+	 * replicated in full. Items in other pages are replicated as placeholders holding only their type and stack count,
+	 * so the client still has every item for aggregates, lookups, sorting, and searching
+	 * @param InPageSize - Number of item slots in each page, or 0 to replicate every item in full
+	 */
+	void SetReplicationPageSize(const int32 InPageSize);
+
+	int32 GetReplicationPageSize() const { return PageSize; }
+	int32 GetNumPages() const { return PageSize > 0 ? FMath::DivideAndRoundUp(Slots.Num(), PageSize) : 0; }
+
+	/**
+	 * Gets the page an item is replicated in. Clients allocate their own slots, so they use the page the server sent
+	 * with the item
+	 * @return The page, or INDEX_NONE if the array isn't paginated or the item doesn't exist
+	 */
+	int32 GetReplicationPage(const int32 ItemID) const;
+
+	/**
+	 * Sets the pages to replicate in full. Newly subscribed pages are streamed in a few per net update instead of all
+	 * at once, while pages that were already streamed keep streaming. Subscriptions belong to the array rather than a
+	 * connection, so this is meant for owner-only replication. Pages that don't exist and duplicates are ignored, and
+	 * only the first MaxSubscribedPages pages are kept
+	 */
+	void SetSubscribedPages(const TArray<int32>& Pages);
+
+	// Most pages that can be subscribed to at once
+	static constexpr int32 MaxSubscribedPages = 64;
+
+	/**
+	 * Sets how many newly subscribed pages start replicating with each net update
+	 */
+	void SetPagesStreamedPerUpdate(const int32 InPagesStreamedPerUpdate) { PagesStreamedPerUpdate = FMath::Max(1, InPagesStreamedPerUpdate); }
+
+	bool IsPageStreamed(const int32 Page) const { return StreamedPages.IsValidIndex(Page) && StreamedPages[Page]; }
+
+	/**
+	 * Recomputes the summaries of the pages that changed since the last call, resizing the summaries to the page count
+	 * @return True if any summary changed
+	 */
+	bool UpdatePageSummaries(TArray<FInventoryPageSummary>& Summaries);
+
+
+	// Batching
+
+	/**
+	 * Starts deferring dirty marks and change notifications until the matching EndBatch call. Batches may be nested,
+	 * and only the outermost EndBatch flushes. Prefer FScopedInventoryBatch over calling this directly
+	 */
+	void BeginBatch() { BatchDepth++; }
+
+	/**
+	 * Ends a batch started with BeginBatch. Closing the outermost batch marks every modified item dirty once, sends
+	 * a single added or changed event per affected item, and notifies the array listeners once
+	 */
+	void EndBatch();
+
+	/**
+	 * Returns true if dirty marks and notifications are currently being deferred
+	 */
+	bool IsBatching() const { return BatchDepth > 0; }
+
+	/**
+	 * Sets whether changes are being made locally on a client ahead of the server. Predicted changes are never marked
+	 * dirty for replication, and new items are kept in a separate list of predicted items, so they aren't given
+	 * replication IDs that could collide with the IDs the server assigns.
+	 * Prefer FScopedInventoryPrediction over calling this directly
+	 */
+	void SetPredictingChanges(const bool bPredicting) { bPredictingChanges = bPredicting; }
+
+	/**
+	 * Returns true if changes are currently being predicted, rather than made by the server or by replication
+	 */
+	bool IsPredictingChanges() const { return bPredictingChanges; }
+
 
 	// Delegates
 
@@ -292,6 +947,39 @@ public:
 	 * Called when any item is modified
 	 */
 	FInventoryArrayChangedDelegate InventoryArrayChangedDelegate;
+
+	/**
+	 * Called with the unique ID of each item added to the array, locally or through replication
+	 */
+	FInventoryArrayItemChangedDelegate ItemAddedDelegate;
+
+	/**
+	 * Called with the unique ID of each item that was marked dirty locally or changed through replication
+	 */
+	FInventoryArrayItemChangedDelegate ItemChangedDelegate;
+
+	/**
+	 * Called with the unique ID of each item about to be removed from the array. The item can still be accessed by its
+	 * ID during the broadcast. Never deferred by batches
+	 */
+	FInventoryArrayItemChangedDelegate ItemRemovedDelegate;
+
+	/**
+	 * Called whenever the array has new state to replicate, so that the owner can mark the array property dirty for
+	 * push model replication
+	 */
+	FInventoryArrayChangedDelegate ReplicationDirtyDelegate;
+
+	/**
+	 * Called after every item was assigned a new unique ID, before the array changed event, so that anything keyed by
+	 * the old IDs can be rebuilt
+	 */
+	FInventoryArrayChangedDelegate ItemIDsReassignedDelegate;
+
+	/**
+	 * Called after a replication update that contained items that couldn't be applied, see ConsumeResyncRequests
+	 */
+	FInventoryArrayChangedDelegate ResyncRequestedDelegate;
 	
 
 	
@@ -305,25 +993,230 @@ protected:
 	void NotifyArrayChanged();
 
 	/**
-	 * Marks the array as dirty, rebuilds the ID map, and notifies any listeners
+	 * Marks the array as dirty and notifies any listeners
 	 */
 	void NotifyItemsDeleted();
 
+	/**
+	 * Broadcasts the per-item events, or records them to be broadcast when the current batch ends
+	 */
+	void NotifyItemAdded(const int32 ItemID);
+	void NotifyItemChanged(const int32 ItemID);
+	void NotifyItemRemoved(const int32 ItemID);
 
-	// Helper functions
+	/**
+	 * Marks an item as dirty for replication, or records it to be marked when the current batch ends
+	 */
+	void MarkItemDirtyDeferred(FInventoryItem& Item);
+
+	/**
+	 * Marks the whole array as dirty for replication, or records it to be marked when the current batch ends
+	 */
+	void MarkArrayDirtyDeferred();
+
+	/**
+	 * Marks an item or the whole array as dirty for replication immediately, and tells the owner the property changed
+	 */
+	void MarkItemDirtyForReplication(FInventoryItem& Item);
+	void MarkArrayDirtyForReplication();
+
+
+	// Slot management
+
+	static constexpr int32 SlotIndexBits = 20;
+	static constexpr int32 SlotIndexMask = (1 << SlotIndexBits) - 1;
+	static constexpr int32 MaxSlotGeneration = (1 << (31 - SlotIndexBits)) - 1;
+
+	static int32 MakeItemID(const int32 SlotIndex, const int32 Generation) { return (Generation << SlotIndexBits) | SlotIndex; }
+	static int32 GetSlotIndex(const int32 UniqueID) { return UniqueID & SlotIndexMask; }
+	static int32 GetSlotGeneration(const int32 UniqueID) { return UniqueID >> SlotIndexBits; }
+
+	/**
+	 * Assigns a free slot and unique ID to the item at the specified index, and adds it to the lookup indices
+	 * @return Unique ID of the item
+	 */
+	int32 AllocateSlot(const int32 ItemIndex);
+
+	/**
+	 * Releases the slot referenced by a unique ID, invalidating any handles that reference it, and removes the item
+	 * from the lookup indices
+	 */
+	void FreeSlot(const int32 UniqueID);
+
+	/**
+	 * Frees every slot and assigns new slots to all items in the array. Only needed when the item array is replaced
+	 * wholesale, such as on load
+	 */
+	void RebuildSlots();
+
+	/**
+	 * Removes the item at the specified index by swapping the last item into its place and updates the slot table
+	 */
+	void RemoveAtSwapInternal(const int32 Index);
+
+	/**
+	 * Replaces the contribution of the given slot's item in the aggregates with its current one, or takes it out if the
+	 * slot is free
+	 */
+	void UpdateAggregates(const int32 SlotIndex);
+
+	/**
+	 * Files the slot's item under its current replication ID in the replication ID map
+	 */
+	void UpdateReplicationIDSlot(const int32 SlotIndex);
+
+	/**
+	 * Look up an element's index by its unique ID
+	 * @return Element's array index or INDEX_NONE if it is not valid. Predicted items have PredictedIndexFlag set
+	 */
+	int32 LookupIndex(const int32 UniqueID) const;
+
+	/**
+	 * Returns true if the item index refers to a predicted item
+	 */
+	static bool IsPredictedIndex(const int32 ItemIndex) { return ItemIndex != INDEX_NONE && (ItemIndex & PredictedIndexFlag) != 0; }
+
+	/**
+	 * Returns true if the item index refers to an existing item, either replicated or predicted
+	 */
+	bool IsValidItemIndex(const int32 ItemIndex) const
+	{
+		return IsPredictedIndex(ItemIndex) ? PredictedItems.IsValidIndex(ItemIndex & ~PredictedIndexFlag) : Items.IsValidIndex(ItemIndex);
+	}
+
+	/**
+	 * Accesses the item at an index returned by LookupIndex, which may refer to a predicted item
+	 */
+	FInventoryItem& GetItemAt(const int32 ItemIndex)
+	{
+		return IsPredictedIndex(ItemIndex) ? PredictedItems[ItemIndex & ~PredictedIndexFlag] : Items[ItemIndex];
+	}
+
+	const FInventoryItem& GetItemAt(const int32 ItemIndex) const
+	{
+		return IsPredictedIndex(ItemIndex) ? PredictedItems[ItemIndex & ~PredictedIndexFlag] : Items[ItemIndex];
+	}
+
+
+	// Lookup indices
+
+	/**
+	 * Files the item in the given slot under its current type and gameplay tags
+	 */
+	void AddToIndices(const int32 SlotIndex);
+
+	/**
+	 * Removes the item in the given slot from the type and gameplay tags it is currently filed under
+	 */
+	void RemoveFromIndices(const int32 SlotIndex);
+
+	/**
+	 * Refiles the item at the specified index if its type changed since it was last indexed, and otherwise refreshes its
+	 * gameplay tags, which can depend on the item data
+	 */
+	void UpdateIndices(const int32 ItemIndex);
+
+	/**
+	 * Returns the IDs of all items with a type equal to the specified type, or nullptr if there are none
+	 */
+	const TArray<int32>* FindIDsByType(const UInventoryItemTypeBase* ItemType) const;
+
+	/**
+	 * Converts a set of slots into handles to the items occupying them
+	 */
+	TArray<FInventoryArrayHandle> GetSlotHandles(const FInventorySlotSet& SlotSet);
+
+
+	// Pagination helpers
+
+	void MarkPageDirty(const int32 SlotIndex);
+
+	/**
+	 * Recomputes which pages are streamed from the subscribed pages, and marks the items of any page that started or
+	 * stopped streaming dirty so they're sent again in their new form
+	 */
+	void UpdateStreamedPages();
+
+
+	// Read snapshot helpers
+
+	/**
+	 * Marks the page and read snapshot chunk containing a slot as changed
+	 */
+	void MarkSlotChanged(const int32 SlotIndex);
+
+
+	// Replication baselines
+
+	// State of an item as it was written, and the serial number it was written with
+	struct FReplicationBaselineItem
+	{
+		FInventoryItem Item;
+		uint32 Serial = 0;
+
+		// Dictionary ID of the item's type definition, or 0 if its type replicates by reference
+		uint32 TypeID = 0;
+	};
+
+	// What a connection was sent up to a particular update
+	struct FReplicationBaseline
+	{
+		// Item states as they were last written to the connection, by replication ID
+		TMap<int32, FReplicationBaselineItem> Items;
+
+		// Dictionary IDs used by the items above. The client drops definitions once none of its items use them, so these
+		// are the only definitions it can be expected to have
+		TSet<uint32> TypeIDs;
+	};
+
+	struct FReplicationBaselineEntry
+	{
+		TWeakPtr<INetDeltaBaseState> BaseState;
+		TSharedPtr<const FReplicationBaseline> Baseline;
+	};
+
+	struct FReplicationWriteContext
+	{
+		FInventoryArray* Array = nullptr;
+		TSharedPtr<const FReplicationBaseline> Baseline;
+		TMap<int32, FReplicationBaselineItem> WrittenItems;
+	};
+
+	// What the client has of a replicated item
+	struct FReceivedItemState
+	{
+		uint32 Serial = 0;
+		uint32 TypeID = 0;
+	};
+
+	// Type definition received by the client, and the number of items using it
+	struct FReceivedTypeDefinition
+	{
+		FInventoryItemTypeDefinition Definition;
+		int32 NumItems = 0;
+	};
+
+	/**
+	 * Finds the baseline attached to a fast array base state, if it is still alive
+	 */
+	TSharedPtr<const FReplicationBaseline> FindReplicationBaseline(const INetDeltaBaseState* BaseState) const;
+
+	/**
+	 * Attaches a baseline to a newly created fast array base state, made from the previous baseline and the items that
+	 * were written during the update
+	 */
+	void StoreReplicationBaseline(const TSharedPtr<INetDeltaBaseState>& BaseState, const FReplicationWriteContext& Context);
 
-	int32 GetNextID() { checkf(LastItemID != INDEX_NONE, TEXT("Inventory array ID exceeded limits - may God have mercy on our souls")); return LastItemID++; }
-	
 	/**
-	* Builds a map of unique item IDs to inventory indices
-	*/
-	void RebuildIDMap();
+	 * Forgets the IDs of type definitions that no baseline uses anymore. A definition that comes back is sent in full
+	 * under a new ID
+	 */
+	void PruneTypeDefinitions();
 
 	/**
-	 * Look up an element's index by its unique ID - will rebuild the ID map if needed
-	 * @return Element's array index or INDEX_NONE if it is not valid
+	 * Changes the received type definition used by an item, dropping definitions that no item uses anymore
 	 */
-	int32 LookupIndex(const int32 UniqueID);
+	void SetReceivedItemTypeID(const int32 ReplicationID, const uint32 TypeID);
 
 	
 private:
@@ -334,17 +1227,152 @@ private:
 	UPROPERTY(VisibleAnywhere)
 	TArray<FInventoryItem> Items;
 
-	UPROPERTY(NotReplicated)
-	TMap<int32, int32> IDtoIndex;
+	// Items a client added ahead of the server. They live outside of the replicated items so the fast array never sees
+	// items without replication IDs, and are discarded once the server's state replaces the prediction
+	UPROPERTY(NotReplicated, Transient)
+	TArray<FInventoryItem> PredictedItems;
 
-	UPROPERTY(NotReplicated)
-	int32 LastItemID = 0;
+	// Set on the item index of slots that refer to predicted items
+	static constexpr int32 PredictedIndexFlag = 1 << 30;
 
-	UPROPERTY(NotReplicated)
-	bool bNeedsIDRebuild = false;
+	// Slot table indexed by the slot portion of an item's unique ID
+	TArray<FInventoryArraySlot> Slots;
 
-	UPROPERTY(NotReplicated)
-	bool bReceivedChanges = false;
+	// Indices of slots that are free to be reused
+	TArray<int32> FreeSlots;
+
+	// Item IDs grouped by equivalent item types
+	TSet<FInventoryTypeIndexEntry, FInventoryTypeIndexKeyFuncs> TypeIndex;
+
+	// Slots grouped by the gameplay tags of their items
+	FInventoryTagIndex TagIndex;
+
+	// Slot indices by the replication ID of their item. Unlike the fast array's item map, it is kept up to date as items
+	// are added, removed, and given their replication IDs
+	TMap<int32, int32> ReplicationIDSlots;
+
+	// Item indices removed during the current replication update, used to fix up slots after swap removal
+	TArray<int32> ReplicatedRemovedIndices;
+
+	// Baselines attached to the fast array base states of each connection. The base state handed back by the replication
+	// system is the last one sent, which may not have arrived, so every written item state is numbered and deltas name
+	// the state they were written against
+	TMap<const INetDeltaBaseState*, FReplicationBaselineEntry> ReplicationBaselines;
+
+	// Serial number for the next item state written by the server
+	uint32 NextReplicationSerial = 1;
+
+	// Replication IDs of items the client asked to be sent in full
+	TSet<int32> ResyncItemIDs;
+
+	// Item states the client has, by replication ID
+	TMap<int32, FReceivedItemState> ReceivedItems;
+
+	// Replication IDs of items the client couldn't apply, waiting to be sent to the server
+	TArray<int32> PendingResyncRequests;
+
+	// Unique IDs of items the client was told about but never received in full. They keep a slot, but aren't reported as
+	// added until a full state arrives
+	TSet<int32> DeferredAddItemIDs;
+
+	// Write context of the array currently writing a replication update, if any
+	static FReplicationWriteContext* ActiveWriteContext;
+
+	// Array currently reading a replication update, if any
+	static FInventoryArray* ActiveReadArray;
+
+	// Dictionary of dynamic type definitions written by the server, the next ID to assign, and the dictionary size that
+	// triggers the next pruning
+	TMap<FInventoryItemTypeDefinition, uint32> TypeDefinitionIDs;
+	uint32 NextTypeDefinitionID = 1;
+	int32 TypeDefinitionPruneThreshold = 64;
+
+	// Type definitions received by the client, by dictionary ID
+	TMap<uint32, FReceivedTypeDefinition> ReceivedTypeDefinitions;
+
+	// Pagination state
+	int32 PageSize = 0;
+	int32 PagesStreamedPerUpdate = 1;
+	TBitArray<> DirtyPages;
+
+	// Subscribed pages in the order they're streamed in, how many of them are streamed so far, and the streamed pages
+	// by page index
+	TArray<int32> SubscribedPages;
+	int32 StreamedPageCount = 0;
+	TBitArray<> StreamedPages;
+
+	// Most recent read snapshot, and which of its chunks have changed since
+	TSharedPtr<const FInventoryReadSnapshot, ESPMode::ThreadSafe> ReadSnapshot;
+	TBitArray<> DirtySnapshotChunks;
+
+	// Sum of the contributions of every slot
+	FInventoryAggregates Aggregates;
+
+	// Incremented whenever items may have moved to different indices, invalidating cached handle indices
+	uint32 Revision = 0;
+
+	// Cleared when this array is destroyed, so that cached handles never touch a destroyed array
+	FInventoryArrayHandleToken HandleToken;
+
+	// Batch state. Sets keep each mark constant time, so a batch touching many items stays linear
+	int32 BatchDepth = 0;
+	TSet<int32> BatchDirtyItemIDs;
+	TSet<int32> BatchAddedItemIDs;
+	TSet<int32> BatchChangedItemIDs;
+	bool bBatchArrayDirty = false;
+	bool bBatchChanged = false;
+
+	// Set while a client applies changes ahead of the server
+	bool bPredictingChanges = false;
+};
+
+
+
+/**
+ * Scope that batches all modifications made to an inventory array while it is alive, so that modified items are marked
+ * dirty once and listeners are notified once when the scope ends
+ */
+struct FScopedInventoryBatch : public FNoncopyable
+{
+	explicit FScopedInventoryBatch(FInventoryArray& InArray)
+		: Array(InArray)
+	{
+		Array.BeginBatch();
+	}
+
+	~FScopedInventoryBatch()
+	{
+		Array.EndBatch();
+	}
+
+private:
+	FInventoryArray& Array;
+};
+
+
+
+/**
+ * Scope that batches all modifications made to an inventory array while it is alive, and treats them as predicted
+ * changes that the server's replicated state will later replace
+ */
+struct FScopedInventoryPrediction : public FNoncopyable
+{
+	explicit FScopedInventoryPrediction(FInventoryArray& InArray)
+		: Array(InArray)
+	{
+		Array.SetPredictingChanges(true);
+		Array.BeginBatch();
+	}
+
+	~FScopedInventoryPrediction()
+	{
+		// The batch flushes its dirty marks first, so they're still treated as predicted
+		Array.EndBatch();
+		Array.SetPredictingChanges(false);
+	}
+
+private:
+	FInventoryArray& Array;
 };
 
 
@@ -358,5 +1386,6 @@ struct TStructOpsTypeTraits<FInventoryArray> : public TStructOpsTypeTraitsBase2<
 	enum 
 	{
 		WithNetDeltaSerializer = true,
+		WithPostSerialize = true,
    };
 };
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Inventory/DataTypes/ItemData.h"
+#include "Inventory/DataTypes/ItemDataStorage.h"
 #include "Inventory/ItemTypes/ItemTypeBase.h"
 #include "InventoryItem.generated.h"
 
@@ -12,6 +13,7 @@
 
 class UInventoryItemTypeBase;
 class APreviewActor;
+struct FInventoryItemTypeDefinition;
 
 
 
@@ -28,6 +30,7 @@ struct INVENTORYSYSTEM_API FInventoryItem : public FFastArraySerializerItem
 	friend class FInventoryItemDetails;
 	friend class UInventoryComponent;
 	friend struct FInventoryArray;
+	friend class FInventoryReadSnapshot;
 
 public:
 	FInventoryItem() {}
@@ -41,7 +44,8 @@ public:
 	{
 		if (Type)
 		{
-			Data = Type->CreateItemData();
+			Type->AddItemReference();
+			Data.Initialize(Type->GetItemDataType());
 		}
 	}
 
@@ -50,11 +54,12 @@ public:
 	 * Copy constructor
 	 */
 	FInventoryItem(const FInventoryItem& OtherItem) :
-		Type(OtherItem.Type), UniqueID(OtherItem.UniqueID)
+		Type(OtherItem.Type), Data(OtherItem.Data), UniqueID(OtherItem.UniqueID),
+		ReplicationPage(OtherItem.ReplicationPage), bPlaceholder(OtherItem.bPlaceholder)
 	{
-		if (OtherItem.Data.IsValid())
+		if (Type)
 		{
-			Data = TSharedPtr<FInventoryItemDataBase>(OtherItem.Data->Copy());
+			Type->AddItemReference();
 		}
 	}
 
@@ -63,7 +68,27 @@ public:
 	 * Move constructor
 	 */
 	FInventoryItem(FInventoryItem&& OtherItem) noexcept :
-		Type(OtherItem.Type), Data(MoveTemp(OtherItem.Data)), UniqueID(OtherItem.UniqueID) {}
+		Type(OtherItem.Type), Data(MoveTemp(OtherItem.Data)), UniqueID(OtherItem.UniqueID),
+		ReplicationPage(OtherItem.ReplicationPage), bPlaceholder(OtherItem.bPlaceholder)
+	{
+		// The other item keeps its type, so this is another reference
+		if (Type)
+		{
+			Type->AddItemReference();
+		}
+	}
+
+
+	/**
+	 * Destructor
+	 */
+	~FInventoryItem()
+	{
+		if (Type)
+		{
+			Type->RemoveItemReference();
+		}
+	}
 
 
 	/**
@@ -71,13 +96,11 @@ public:
 	 */
 	FInventoryItem& operator=(const FInventoryItem& OtherItem)
 	{
-		Type = OtherItem.Type;
+		AssignType(OtherItem.Type);
+		Data = OtherItem.Data;
 		UniqueID = OtherItem.UniqueID;
-
-		if (OtherItem.Data.IsValid())
-		{
-			Data = TSharedPtr<FInventoryItemDataBase>(OtherItem.Data->Copy());
-		}
+		ReplicationPage = OtherItem.ReplicationPage;
+		bPlaceholder = OtherItem.bPlaceholder;
 
 		return *this;
 	}
@@ -88,9 +111,11 @@ public:
 	 */
 	FInventoryItem& operator=(FInventoryItem&& OtherItem) noexcept
 	{
-		Type = OtherItem.Type;
+		AssignType(OtherItem.Type);
 		Data = MoveTemp(OtherItem.Data);
 		UniqueID = OtherItem.UniqueID;
+		ReplicationPage = OtherItem.ReplicationPage;
+		bPlaceholder = OtherItem.bPlaceholder;
 
 		return *this;
 	}
@@ -154,7 +179,7 @@ public:
 	 * Try set the number of items in a stack of this type - does not need to check against max stack size
 	 * @param Count - Number of items of this type try to set
 	 */
-	void SetStackCount(const int32 Count) const;
+	void SetStackCount(const int32 Count);
 
 	/**
 	 * Used to get the number of items in a stack of this type
@@ -173,9 +198,39 @@ public:
 	// Data accessors
 
 	UInventoryItemTypeBase* GetType() const { return Type; }
-	TWeakPtr<FInventoryItemDataBase> GetData() const { return Data; }
+	int32 GetUniqueID() const { return UniqueID; }
+
+	/**
+	 * Items received from a paginated inventory array outside of the subscribed pages only hold their type and stack
+	 * count, with the rest of their data left at its defaults
+	 */
+	bool IsPlaceholder() const { return bPlaceholder; }
+
+	// Page the server replicated the item from, or INDEX_NONE if it wasn't replicated by a paginated array
+	int32 GetReplicationPage() const { return ReplicationPage; }
+	// Mutable access detaches the data from any copies of this item that share it
+	FInventoryItemDataBase* GetData() { return Data.GetMutable(); }
+	const FInventoryItemDataBase* GetData() const { return Data.Get(); }
 	void SetType(UInventoryItemTypeBase* NewType);
 
+	/**
+	 * Typed data access without any virtual calls
+	 * @return The item data if it is exactly the requested type, null otherwise
+	 */
+	template <typename DataType>
+	const DataType* GetDataAs() const
+	{
+		static_assert(TIsDerivedFrom<DataType, FInventoryItemDataBase>::IsDerived, "Data type must be derived from FInventoryItemDataBase");
+		return Data.GetScriptStruct() == DataType::StaticStruct() ? static_cast<const DataType*>(Data.Get()) : nullptr;
+	}
+
+	template <typename DataType>
+	DataType* GetDataAs()
+	{
+		static_assert(TIsDerivedFrom<DataType, FInventoryItemDataBase>::IsDerived, "Data type must be derived from FInventoryItemDataBase");
+		return Data.GetScriptStruct() == DataType::StaticStruct() ? static_cast<DataType*>(Data.GetMutable()) : nullptr;
+	}
+
 
 	// Serialization
 	
@@ -184,18 +239,96 @@ public:
 
 
 private:
+	/**
+	 * Replaces the type pointer without touching the item data, keeping the reference counts of pooled types
+	 */
+	void AssignType(UInventoryItemTypeBase* NewType)
+	{
+		if (NewType == Type)
+		{
+			return;
+		}
+
+		if (NewType)
+		{
+			NewType->AddItemReference();
+		}
+
+		if (Type)
+		{
+			Type->RemoveItemReference();
+		}
+
+		Type = NewType;
+	}
+
+
+	// Serialization helpers
+
+	/**
+	 * Serializes the item state numbered for the inventory array being replicated, relative to the baseline the
+	 * connection has if possible
+	 */
+	bool NetSerializeState(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess);
+
+	/**
+	 * Makes a copy of the item holding only what a placeholder keeps - its type and stack count
+	 */
+	FInventoryItem MakePlaceholder() const;
+
+	/**
+	 * Serializes the item type followed by all of the item data
+	 * @return False if loading and the item type couldn't be resolved
+	 */
+	bool NetSerializeFull(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess);
+
+	/**
+	 * Serializes a type that isn't supported for networking as a definition of its state, or as an ID in the type
+	 * dictionary of the inventory array being replicated when the receiver already has the definition
+	 * @param bOutReferenceOnly - Set if only a dictionary ID was serialized
+	 * @return False if loading and the referenced definition was never received
+	 */
+	bool NetSerializeDynamicType(FArchive& Ar, UPackageMap* PackageMap, bool& bOutReferenceOnly, bool& bOutSuccess);
+
+	/**
+	 * Updates our type to match a received definition, recycling type objects through the item type pool
+	 */
+	void ApplyTypeDefinition(const FInventoryItemTypeDefinition& Definition, UPackageMap* PackageMap, bool& bOutSuccess);
+
+	/**
+	 * Serializes only the item data properties that differ from a baseline state, leaving the type out entirely. The
+	 * baseline is only needed when saving, and when loading the delta is only applied if we have the state with the
+	 * baseline's serial number
+	 * @return False if loading and the delta was skipped because we don't have its baseline
+	 */
+	bool NetSerializeDelta(FArchive& Ar, UPackageMap* PackageMap, const FInventoryItem* Baseline, const uint32 BaselineSerial, bool& bOutSuccess);
+
+	/**
+	 * Checks if the item can be written relative to a baseline - the type must be the same networked object, since the
+	 * receiver keeps its own type reference
+	 */
+	bool CanNetSerializeDelta(const FInventoryItem& Baseline) const;
+
+
 	// Storage
 	
 	UPROPERTY(EditAnywhere, meta=(AllowPrivateAccess="true"))
 	UInventoryItemTypeBase* Type = nullptr;
 
-	TSharedPtr<FInventoryItemDataBase> Data = nullptr;
+	// Item data is stored inline when it is small enough, see INVENTORY_ITEM_DATA_INLINE_SIZE
+	FInventoryItemDataStorage Data;
 
 
 	// Unique ID for fast lookup in inventory component
 
 	UPROPERTY(NotReplicated)
 	int32 UniqueID = INDEX_NONE;
+
+
+	// Pagination state received from the server
+
+	int32 ReplicationPage = INDEX_NONE;
+	bool bPlaceholder = false;
 };
 
 
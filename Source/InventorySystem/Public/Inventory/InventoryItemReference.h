@@ -0,0 +1,75 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventoryItemReference.generated.h"
+
+
+
+// Forward declarations
+
+class UInventoryComponent;
+class UInventoryItemTypeBase;
+struct FInventoryItem;
+struct FInventoryArrayHandle;
+
+
+
+/**
+ * Compact reference to an item in an inventory, for sending to the inventory's owner in RPCs instead of a copy of the
+ * item. The owner already receives the item through the replicated inventory, so only the item's replication ID and a
+ * count are sent, along with the item type when it replicates by reference
+ */
+USTRUCT()
+struct INVENTORYSYSTEM_API FInventoryItemNetReference
+{
+	GENERATED_BODY()
+
+	FInventoryItemNetReference() {}
+
+	/**
+	 * Makes a reference to an item in an inventory on the server. Items that haven't been given a replication ID yet, such
+	 * as items added inside a batch that hasn't ended, are only referenced by their type (if it replicates by reference),
+	 * so the reference may not be valid
+	 * @param ItemHandle - Handle to the item, which should have been marked dirty so that it has a replication ID
+	 * @param InCount - Number of items the reference stands for, such as the count added by a pickup
+	 */
+	FInventoryItemNetReference(const FInventoryArrayHandle& ItemHandle, const int32 InCount);
+
+	/**
+	 * Finds the referenced item in the owner's copy of the inventory. Types that replicate by reference are resolved
+	 * even before the item replicates, without any item data
+	 * @param InventoryComponent - Inventory the reference was made in
+	 * @param OutItem - Copy of the referenced item, with its stack count set to the referenced count if it stacks
+	 * @return False if the item can't be resolved yet
+	 */
+	bool Resolve(UInventoryComponent* InventoryComponent, FInventoryItem& OutItem) const;
+
+	bool IsValid() const { return Type || ReplicationID != INDEX_NONE; }
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess);
+
+
+	// Item type, if it is supported for networking
+	UPROPERTY()
+	UInventoryItemTypeBase* Type = nullptr;
+
+	// Replication ID of the item in the inventory array
+	int32 ReplicationID = INDEX_NONE;
+
+	int32 Count = 0;
+};
+
+
+/**
+ * Type traits for the struct to tell the engine to use the custom net serialization function
+ */
+template <>
+struct TStructOpsTypeTraits<FInventoryItemNetReference> : TStructOpsTypeTraitsBase2<FInventoryItemNetReference>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
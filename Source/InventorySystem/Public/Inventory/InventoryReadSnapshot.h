@@ -0,0 +1,97 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/InventoryItem.h"
+#include "UObject/ObjectKey.h"
+
+
+
+/**
+ * Immutable view of the items in an inventory array at one point in time, which can be read from any thread while the
+ * array keeps changing. Snapshots are made of reference counted chunks of item slots, and a snapshot taken after a
+ * change shares every chunk that the change didn't touch with the snapshot before it. Item data is shared with the live
+ * items until the inventory modifies them.
+ *
+ * Item types aren't kept alive by snapshots, so whatever reading an item needs from its type is captured along with it
+ * on the game thread, and the type itself is only kept as a key to compare against
+ */
+class INVENTORYSYSTEM_API FInventoryReadSnapshot
+{
+	friend struct FInventoryArray;
+
+public:
+
+	// Number of item slots in each chunk
+	static constexpr int32 ChunkSize = 64;
+
+
+	/**
+	 * An item as it was when the snapshot was taken
+	 */
+	class INVENTORYSYSTEM_API FItem
+	{
+	public:
+		/**
+		 * Captures an item, reading what's needed from its type. Must be called on the game thread
+		 */
+		explicit FItem(const FInventoryItem& Item);
+
+		int32 GetUniqueID() const { return UniqueID; }
+		TObjectKey<UInventoryItemTypeBase> GetTypeKey() const { return TypeKey; }
+		const FInventoryItemTypeTraits& GetTypeTraits() const { return TypeTraits; }
+		int32 GetStackCount() const { return StackCount; }
+		bool IsValid() const { return bValid; }
+		const FInventoryItemDataBase* GetData() const { return Data.Get(); }
+
+		template <typename DataType>
+		const DataType* GetDataAs() const
+		{
+			static_assert(TIsDerivedFrom<DataType, FInventoryItemDataBase>::IsDerived, "Data type must be derived from FInventoryItemDataBase");
+			return Data.GetScriptStruct() == DataType::StaticStruct() ? static_cast<const DataType*>(Data.Get()) : nullptr;
+		}
+
+
+	private:
+		int32 UniqueID = INDEX_NONE;
+		TObjectKey<UInventoryItemTypeBase> TypeKey;
+		FInventoryItemTypeTraits TypeTraits;
+		int32 StackCount = 0;
+		bool bValid = false;
+
+		// Shared with the live item until the inventory modifies it
+		FInventoryItemDataStorage Data;
+	};
+
+
+	// Item access
+
+	int32 Num() const { return NumItems; }
+
+	/**
+	 * Calls the visitor with each item in slot order. The visitor returns false to stop early
+	 */
+	void ForEachItem(TFunctionRef<bool(const FItem&)> Visitor) const;
+
+	/**
+	 * Finds an item by its unique ID, as it was when the snapshot was taken
+	 * @return The item, or null if no item had the ID
+	 */
+	const FItem* FindItem(const int32 UniqueID) const;
+
+
+
+private:
+
+	// Items of a range of slots, in slot order
+	struct FChunk
+	{
+		TArray<FItem> Items;
+	};
+
+	using FChunkRef = TSharedRef<const FChunk, ESPMode::ThreadSafe>;
+
+	TArray<FChunkRef> Chunks;
+	int32 NumItems = 0;
+};
@@ -0,0 +1,195 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Inventory/InventoryItem.h"
+
+
+
+/**
+ * Compact binary snapshot of inventory items, used for persistence instead of tagged serialization. Item types are
+ * written once to a type table, by primary asset ID where the asset manager can resolve it, and item data is written
+ * as untagged payloads described by a schema table. Data structs made of plain old data fields use a fixed layout, so
+ * their payloads are copied field by field, and still load after fields are added, removed or reordered.
+ *
+ * Reading a snapshot only parses its tables and locates the item records - each item is materialized the first time
+ * it is accessed. Materialized items only keep their types alive once they are stored in a UPROPERTY, such as an
+ * inventory array, so they should be moved out of the snapshot before the next garbage collection
+ */
+class INVENTORYSYSTEM_API FInventorySnapshot
+{
+public:
+
+	// Versioning
+
+	enum class EVersion : int32
+	{
+		Initial = 1,
+
+		// New versions go above this line
+		VersionPlusOne,
+		Latest = VersionPlusOne - 1
+	};
+
+	static constexpr uint32 Magic = 0x53564E49;
+
+
+	// Writing
+
+	class FWriter;
+
+	/**
+	 * Writes items to a new snapshot. Items without a type are left out
+	 */
+	static void Write(TArrayView<const FInventoryItem> Items, TArray<uint8>& OutData);
+
+
+	// Reading
+
+	/**
+	 * Takes ownership of snapshot data, and parses its tables without materializing any items
+	 * @return False if the data isn't a valid snapshot, or was written by a newer version
+	 */
+	bool Read(TArray<uint8>&& InData);
+
+	int32 Num() const { return Records.Num(); }
+
+	/**
+	 * Accesses an item, materializing it the first time. Must be called on the game thread unless ResolveTypes was
+	 * called first, since item types may be loaded when first referenced
+	 * @return The item, which is invalid if its type or data struct no longer exists
+	 */
+	const FInventoryItem& GetItem(const int32 Index);
+
+	/**
+	 * Materializes every valid item, moving them out of the snapshot. Must be called on the game thread unless
+	 * ResolveTypes was called first
+	 */
+	void MaterializeAll(TArray<FInventoryItem>& OutItems);
+
+	/**
+	 * Resolves every item type and data struct up front on the game thread, so that items can then be materialized on
+	 * any thread. The resolved types aren't referenced by the snapshot, so they must be kept alive until the items are
+	 * stored somewhere visible to the garbage collector
+	 * @param OutTypes - Appended with the resolved types
+	 */
+	void ResolveTypes(TArray<UInventoryItemTypeBase*>& OutTypes);
+
+
+
+private:
+
+	// Tables
+
+	enum class ETypeReferenceKind : uint8
+	{
+		// Asset types that the asset manager can find by primary asset ID
+		AssetID,
+
+		// Asset types that aren't known to the asset manager
+		ObjectPath,
+
+		// Types created at runtime, stored as a class and tagged properties
+		Dynamic
+	};
+
+	struct FTypeEntry
+	{
+		ETypeReferenceKind Kind = ETypeReferenceKind::AssetID;
+		FPrimaryAssetId AssetID;
+
+		// Object path of asset types, or class path of dynamic types
+		FString Path;
+		TArray<uint8> DynamicProperties;
+		int32 SchemaIndex = INDEX_NONE;
+
+		// Resolved when first referenced
+		UInventoryItemTypeBase* Type = nullptr;
+		bool bResolved = false;
+	};
+
+	struct FSchemaField
+	{
+		FString Name;
+		FString CPPType;
+		int32 Size = 0;
+	};
+
+	struct FFieldMapping
+	{
+		const FProperty* Property = nullptr;
+		int32 Offset = 0;
+		int32 Size = 0;
+	};
+
+	struct FSchema
+	{
+		FString StructPath;
+		uint32 Hash = 0;
+
+		// Fixed layout payloads are the fields copied back to back, otherwise they are untagged binary serialization
+		bool bFixedLayout = false;
+		int32 PayloadSize = 0;
+		TArray<FSchemaField> Fields;
+
+		// Resolved when first referenced
+		UScriptStruct* Struct = nullptr;
+		TArray<FFieldMapping> FieldMappings;
+		bool bMatchesStruct = false;
+		bool bResolved = false;
+	};
+
+	struct FItemRecord
+	{
+		int32 TypeIndex = INDEX_NONE;
+		int32 PayloadOffset = 0;
+		int32 PayloadSize = 0;
+	};
+
+
+	// Serialization helpers
+
+	static FSchema MakeSchema(UScriptStruct* Struct);
+	static FTypeEntry MakeTypeEntry(UInventoryItemTypeBase* Type);
+	static void SerializeSchema(FArchive& Ar, FSchema& Schema);
+	static void SerializeTypeEntry(FArchive& Ar, FTypeEntry& Entry);
+	static void WritePayload(FArchive& Ar, const FSchema& Schema, const FInventoryItemDataBase& ItemData);
+
+	UInventoryItemTypeBase* ResolveType(FTypeEntry& Entry);
+	FSchema* ResolveSchema(const int32 SchemaIndex);
+	FInventoryItem MaterializeItem(const FItemRecord& Record);
+
+
+	// Storage
+
+	TArray<uint8> Data;
+	TArray<FTypeEntry> Types;
+	TArray<FSchema> Schemas;
+	TArray<FItemRecord> Records;
+	TArray<TOptional<FInventoryItem>> MaterializedItems;
+};
+
+
+
+/**
+ * Items captured for writing to a snapshot. Capturing builds the type and schema tables and encodes the item records,
+ * which reads type and data properties, so it has to happen on the game thread. Writing only assembles the captured
+ * bytes, so it can happen on any thread while the inventory keeps changing
+ */
+class INVENTORYSYSTEM_API FInventorySnapshot::FWriter
+{
+public:
+	explicit FWriter(TArrayView<const FInventoryItem> InItems);
+
+	void Write(TArray<uint8>& OutData) const;
+
+	
+private:
+	TArray<FTypeEntry> Types;
+	TArray<FSchema> Schemas;
+
+	// Encoded records of the items with a type, each its index in the type table followed by its payload
+	TArray<uint8> ItemRecords;
+	int32 NumItems = 0;
+};
@@ -0,0 +1,122 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventorySortIndex.generated.h"
+
+
+
+// Forward declarations
+
+struct FInventoryItem;
+
+
+
+/**
+ * Orders available for sorted inventory views
+ */
+UENUM(BlueprintType)
+enum class EInventorySortMode : uint8
+{
+	// Alphabetical by display name
+	Name,
+
+	// Grouped by item type, then alphabetical by display name
+	Type,
+
+	// Largest stacks first, then alphabetical by display name
+	StackCount,
+
+	MAX UMETA(Hidden)
+};
+
+
+
+/**
+ * Sort and search keys precomputed from an inventory item, so that sorting and filtering never has to query the item
+ * type or compare FText
+ */
+struct FInventorySortKeys
+{
+	// Lowercase display name, used both as the name sort key and for searching
+	FString NameKey;
+
+	// Lowercase item type path, which stays the same across runs and for equal runtime types
+	FString TypeKey;
+
+	int32 StackCount = 0;
+};
+
+
+
+/**
+ * Index of precomputed sort keys and sorted views of the items in an inventory. The index is built on first use, and
+ * after that each sorted view is maintained incrementally by repositioning only the items that were added, changed, or
+ * removed
+ */
+class INVENTORYSYSTEM_API FInventorySortIndex
+{
+public:
+
+	// Index modification
+
+	/**
+	 * Discards all keys and views, so that the index is rebuilt the next time it is used
+	 */
+	void Reset();
+
+	/**
+	 * Builds the keys for every item. Views are sorted lazily the first time they are requested
+	 */
+	void Build(const TArray<FInventoryItem>& Items);
+
+	/**
+	 * Item update functions, which can be skipped while the index isn't built
+	 */
+	void AddItem(const FInventoryItem& Item);
+	void UpdateItem(const FInventoryItem& Item);
+	void RemoveItem(const int32 ItemID);
+
+
+	// Queries
+
+	bool IsBuilt() const { return bBuilt; }
+
+	/**
+	 * Returns the IDs of all indexed items in sorted order
+	 */
+	const TArray<int32>& GetSortedItemIDs(const EInventorySortMode SortMode);
+
+	/**
+	 * Appends the IDs of all indexed items whose names contain the search text, ignoring case, in sorted order
+	 */
+	void SearchByName(const FString& SearchText, const EInventorySortMode SortMode, TArray<int32>& OutItemIDs);
+
+	/**
+	 * Returns the precomputed keys of an item, or null if the item isn't indexed
+	 */
+	const FInventorySortKeys* FindKeys(const int32 ItemID) const { return Keys.Find(ItemID); }
+
+
+private:
+
+	// Helper functions
+
+	static FInventorySortKeys MakeKeys(const FInventoryItem& Item);
+	bool IsLess(const EInventorySortMode SortMode, const int32 ItemA, const int32 ItemB) const;
+	void InsertIntoViews(const int32 ItemID);
+	void RemoveFromViews(const int32 ItemID);
+	int32 LowerBound(const EInventorySortMode SortMode, const int32 ItemID) const;
+
+
+	static constexpr int32 NumSortModes = static_cast<int32>(EInventorySortMode::MAX);
+
+	TMap<int32, FInventorySortKeys> Keys;
+
+	// Sorted item IDs for each sort mode, and whether each view has been sorted yet
+	TArray<int32> SortedViews[NumSortModes];
+	bool bViewSorted[NumSortModes] = {};
+
+	bool bBuilt = false;
+};
@@ -0,0 +1,86 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InventorySummary.generated.h"
+
+
+
+// Forward declarations
+
+class UInventoryItemTypeBase;
+
+
+
+/**
+ * Publicly visible item in an inventory summary
+ */
+USTRUCT(BlueprintType)
+struct INVENTORYSYSTEM_API FInventorySummaryEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category=Inventory)
+	UInventoryItemTypeBase* Type = nullptr;
+
+	UPROPERTY(BlueprintReadOnly, Category=Inventory)
+	int32 StackCount = 0;
+
+	bool operator==(const FInventorySummaryEntry& Other) const
+	{
+		return Type == Other.Type && StackCount == Other.StackCount;
+	}
+};
+
+
+
+/**
+ * Compact view of an inventory that is replicated to everyone except the inventory's owner, who receives the full item
+ * array instead. Only holds the items that other players are allowed to see, such as equipped or worn items
+ */
+USTRUCT(BlueprintType)
+struct INVENTORYSYSTEM_API FInventorySummary
+{
+	GENERATED_BODY()
+
+	// Visible items in slot order. Items with types that aren't supported for networking are left out
+	UPROPERTY(BlueprintReadOnly, Category=Inventory)
+	TArray<FInventorySummaryEntry> VisibleItems;
+
+	// Total number of items in the inventory, visible or not
+	UPROPERTY(BlueprintReadOnly, Category=Inventory)
+	int32 ItemCount = 0;
+
+	bool operator==(const FInventorySummary& Other) const
+	{
+		return ItemCount == Other.ItemCount && VisibleItems == Other.VisibleItems;
+	}
+
+	bool operator!=(const FInventorySummary& Other) const { return !(*this == Other); }
+};
+
+
+
+/**
+ * Replicated stand-in for a page of a paginated inventory array, so clients know what a page holds without subscribing
+ * to it. The checksum changes whenever any item in the page changes type or stack count
+ */
+USTRUCT(BlueprintType)
+struct INVENTORYSYSTEM_API FInventoryPageSummary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category=Inventory)
+	int32 ItemCount = 0;
+
+	UPROPERTY()
+	uint32 Checksum = 0;
+
+	bool operator==(const FInventoryPageSummary& Other) const
+	{
+		return ItemCount == Other.ItemCount && Checksum == Other.Checksum;
+	}
+
+	bool operator!=(const FInventoryPageSummary& Other) const { return !(*this == Other); }
+};
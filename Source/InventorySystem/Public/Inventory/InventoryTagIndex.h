@@ -0,0 +1,119 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+
+
+/**
+ * Compact set of inventory slot indices, stored as one bit per slot
+ */
+struct INVENTORYSYSTEM_API FInventorySlotSet
+{
+public:
+
+	// Set operations
+
+	void Add(const int32 SlotIndex);
+	void Remove(const int32 SlotIndex);
+	bool Contains(const int32 SlotIndex) const;
+	bool IsEmpty() const;
+	int32 Num() const;
+	void Reset() { Words.Reset(); }
+
+	FInventorySlotSet& operator&=(const FInventorySlotSet& Other);
+	FInventorySlotSet& operator|=(const FInventorySlotSet& Other);
+
+	/**
+	 * Removes all slots that are contained in the other set
+	 */
+	FInventorySlotSet& Subtract(const FInventorySlotSet& Other);
+
+	/**
+	 * Calls the functor with the index of every slot in the set, in ascending order
+	 */
+	template <typename FunctorType>
+	void ForEach(FunctorType&& Functor) const
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); WordIndex++)
+		{
+			uint32 Word = Words[WordIndex];
+
+			while (Word)
+			{
+				Functor(WordIndex * BitsPerWord + static_cast<int32>(FMath::CountTrailingZeros(Word)));
+
+				// Clear the lowest set bit
+				Word &= Word - 1;
+			}
+		}
+	}
+
+
+private:
+	static constexpr int32 BitsPerWord = 32;
+
+	TArray<uint32, TInlineAllocator<4>> Words;
+};
+
+
+
+/**
+ * Inverted index from gameplay tags to the inventory slots holding items with those tags. Items are filed under their
+ * explicit tags and all of the parents of those tags, so that tag queries can be evaluated with set operations that
+ * give the same results as matching the query against each item's tags
+ */
+class INVENTORYSYSTEM_API FInventoryTagIndex
+{
+public:
+
+	// Index modification
+
+	/**
+	 * Files a slot under all of the specified tags and their parents
+	 */
+	void AddSlot(const int32 SlotIndex, const FGameplayTagContainer& Tags);
+
+	/**
+	 * Refiles a slot that is already in the index under a new set of tags, adding and removing only the tags that
+	 * changed
+	 */
+	void UpdateSlot(const int32 SlotIndex, const FGameplayTagContainer& Tags);
+
+	/**
+	 * Removes a slot from every tag it is filed under
+	 */
+	void RemoveSlot(const int32 SlotIndex);
+
+	/**
+	 * Removes all slots from the index
+	 */
+	void Reset();
+
+
+	// Queries
+
+	/**
+	 * Returns the set of all slots with items that match the tag query
+	 */
+	FInventorySlotSet Evaluate(const FGameplayTagQuery& Query) const;
+
+	/**
+	 * Returns the set of all slots with items that have the tag (or a child of the tag)
+	 */
+	FInventorySlotSet FindSlotsWithTag(const FGameplayTag& Tag) const;
+
+
+private:
+
+	// Helper functions
+
+	FInventorySlotSet EvaluateExpression(const FGameplayTagQueryExpression& Expression) const;
+	FInventorySlotSet UnionOfTags(const TArray<FGameplayTag>& Tags) const;
+
+
+	TMap<FGameplayTag, FInventorySlotSet> TagToSlots;
+	FInventorySlotSet AllSlots;
+};
@@ -22,18 +22,22 @@ public:
 	// Item type base overrides
 	
 	virtual bool NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess) override;
-	virtual FText GetItemName(TWeakPtr<FInventoryItemDataBase> ItemData) const override { return ItemName; }
-	virtual FText GetItemDescription(TWeakPtr<FInventoryItemDataBase> ItemData) const override { return ItemDescription; }
-	virtual TSoftClassPtr<APreviewActor> GetPreviewActorClass(TWeakPtr<FInventoryItemDataBase> ItemData) const override { return PreviewActorClass; }
-	virtual TSoftObjectPtr<UTexture2D> GetThumbnailImage(TWeakPtr<FInventoryItemDataBase> ItemData) const override { return ThumbnailImage; }
-	virtual FGameplayTagContainer GetGameplayTags(TWeakPtr<FInventoryItemDataBase> ItemData) const override { return GameplayTags; }
+	virtual FText GetItemName(const FInventoryItemDataBase* ItemData) const override { return ItemName; }
+	virtual FText GetItemDescription(const FInventoryItemDataBase* ItemData) const override { return ItemDescription; }
+	virtual TSoftClassPtr<APreviewActor> GetPreviewActorClass(const FInventoryItemDataBase* ItemData) const override { return PreviewActorClass; }
+	virtual TSoftObjectPtr<UTexture2D> GetThumbnailImage(const FInventoryItemDataBase* ItemData) const override { return ThumbnailImage; }
+	virtual FGameplayTagContainer GetGameplayTags(const FInventoryItemDataBase* ItemData) const override { return GameplayTags; }
 	virtual bool AllowsDuplicates() const override { return bAllowsDuplicates; }
+	virtual float GetUnitWeight() const override { return UnitWeight; }
+	virtual float GetUnitValue() const override { return UnitValue; }
+	virtual int32 GetSlotCost() const override { return SlotCost; }
 
 
 	// Operator overloads
 
 	virtual bool operator==(const UInventoryItemTypeBase& OtherType) const override;
 	bool operator==(const UInventoryItemType& OtherType) const;
+	virtual uint32 GetItemTypeHash() const override;
 
 
 	// Editor properties
@@ -55,4 +59,16 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=ItemType)
 	bool bAllowsDuplicates = true;
+
+	// Weight of each item, counted against the weight limit of inventories
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=ItemType, meta=(ClampMin=0))
+	float UnitWeight = 0.f;
+
+	// Value of each item
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=ItemType)
+	float UnitValue = 0.f;
+
+	// Inventory slots taken up by each item or stack, counted against the slot limit of inventories
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=ItemType, meta=(ClampMin=0))
+	int32 SlotCost = 1;
 };
@@ -13,6 +13,32 @@ struct FInventoryItemDataBase;
 class APreviewActor;
 
 
+
+/**
+ * Item type properties cached as plain data, so that hot inventory operations can check them without virtual calls
+ */
+struct FInventoryItemTypeTraits
+{
+	// Item data struct, or null if the type doesn't use item data
+	UScriptStruct* DataType = nullptr;
+
+	// Maximum stack size, only used when stack operations can work directly on the stack data
+	int32 MaxStackSize = 0;
+
+	bool bAllowsDuplicates = true;
+	bool bAllowsStacking = false;
+
+	// Contributions of each item towards the running totals of an inventory
+	float UnitWeight = 0.f;
+	float UnitValue = 0.f;
+	int32 SlotCost = 1;
+
+	// Whether the item data is FInventoryStackData and the standard stack operations apply to it, so stack operations
+	// can skip the item type entirely
+	bool bDirectStackData = false;
+};
+
+
 /*
  * Class used as the base for any inventory item type. Most classes should probably inherit from UInventoryItemType
  * instead of this.
@@ -23,6 +49,67 @@ class INVENTORYSYSTEM_API UInventoryItemTypeBase : public UPrimaryDataAsset
 	GENERATED_BODY()
 	
 public:
+
+	// UObject overrides
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+
+	// Type traits
+
+	/**
+	 * Used by inventory items and components to check type properties without virtual calls
+	 */
+	const FInventoryItemTypeTraits& GetTypeTraits() const { return TypeTraits; }
+
+	/**
+	 * Updates the cached type traits from the virtual accessors. Called automatically on load, on edit, and after
+	 * replicating a dynamic type, but must be called manually after changing properties that affect traits at runtime
+	 */
+	virtual void RefreshTypeTraits();
+
+
+	// Pooling
+
+	/**
+	 * Counts an item referencing this type, if the type was created by the item type pool. Copies of items count too,
+	 * so the pool only reuses a type once nothing can see it anymore. Types from anywhere else aren't counted
+	 */
+	void AddItemReference() const
+	{
+		if (bPooled)
+		{
+			PooledItemReferences.Increment();
+		}
+	}
+
+	void RemoveItemReference() const
+	{
+		if (bPooled)
+		{
+			PooledItemReferences.Decrement();
+		}
+	}
+
+	/**
+	 * Returns true if any item or copy of an item still refers to this pooled type. Can be called from any thread
+	 */
+	bool HasItemReferences() const { return PooledItemReferences.GetValue() > 0; }
+
+	/**
+	 * Returns true if the type was created by the pool and a single item refers to it, so that item can change it in
+	 * place without any copies seeing the change
+	 */
+	bool IsExclusivelyReferenced() const { return bPooled && PooledItemReferences.GetValue() == 1; }
+
+
+	// Item type interface
+
 	/**
 	 * Called when replicating an ItemType if it is not supported for networking (IsSupportedForNetworking() returns false).
 	 * Functions similarly to standard NetSerialize on structs.
@@ -35,41 +122,35 @@ public:
 	 */
 	virtual UScriptStruct* GetItemDataType() const { return nullptr; }
 	
-	/**
-	 * Allocates new item data specific to this item type
-	 * @return Pointer to new item data
-	 */
-	virtual TSharedPtr<FInventoryItemDataBase> CreateItemData() const { return TSharedPtr<FInventoryItemDataBase>(); }
-
 	/**
 	 * Used to get the name of this item as it should appear in the inventory UI
 	 * @param ItemData - Optional item data relevant to this item type
 	 */
-	virtual FText GetItemName(TWeakPtr<FInventoryItemDataBase> ItemData) const { return FText(); }
+	virtual FText GetItemName(const FInventoryItemDataBase* ItemData) const { return FText(); }
 
 	/**
 	 * Used to get the description of this item as it should appear in the inventory UI
 	 * @param ItemData - Optional item data relevant to this item type
 	 */
-	virtual FText GetItemDescription(TWeakPtr<FInventoryItemDataBase> ItemData) const { return FText(); }
+	virtual FText GetItemDescription(const FInventoryItemDataBase* ItemData) const { return FText(); }
 
 	/**
 	 * Used to get an actor that can be rendered as a 3D display for this inventory item
 	 * @param ItemData - Optional item data relevant to this item type
 	 */
-	virtual TSoftClassPtr<APreviewActor> GetPreviewActorClass(TWeakPtr<FInventoryItemDataBase> ItemData) const { return nullptr; }
+	virtual TSoftClassPtr<APreviewActor> GetPreviewActorClass(const FInventoryItemDataBase* ItemData) const { return nullptr; }
 
 	/**
 	 * Used to get an image for displaying a thumbnail of this inventory item
 	 * @param ItemData - Optional item data relevant to this item type
 	 */
-	virtual TSoftObjectPtr<UTexture2D> GetThumbnailImage(TWeakPtr<FInventoryItemDataBase> ItemData) const { return nullptr; }
+	virtual TSoftObjectPtr<UTexture2D> GetThumbnailImage(const FInventoryItemDataBase* ItemData) const { return nullptr; }
 
 	/**
 	 * Used to get gameplay tags describing this item
 	 * @param ItemData - Optional item data relevant to this item type
 	 */
-	virtual FGameplayTagContainer GetGameplayTags(TWeakPtr<FInventoryItemDataBase> ItemData) const { return FGameplayTagContainer::EmptyContainer; }
+	virtual FGameplayTagContainer GetGameplayTags(const FInventoryItemDataBase* ItemData) const { return FGameplayTagContainer::EmptyContainer; }
 
 	/**
 	 * Overridden to determine inventory storage behavior
@@ -83,6 +164,24 @@ public:
 	 */
 	virtual bool AllowsStacking() const { return false; }
 
+	/**
+	 * Overridden to determine inventory capacity usage
+	 * @return Weight of a single item of this type, counted for every item in a stack
+	 */
+	virtual float GetUnitWeight() const { return 0.f; }
+
+	/**
+	 * Overridden to determine inventory worth
+	 * @return Value of a single item of this type, counted for every item in a stack
+	 */
+	virtual float GetUnitValue() const { return 0.f; }
+
+	/**
+	 * Overridden to determine inventory capacity usage
+	 * @return Number of inventory slots taken up by each item or stack of this type
+	 */
+	virtual int32 GetSlotCost() const { return 1; }
+
 	/**
 	 * Try to add items to a stack of this type. Must be implemented for any type that allows stacking
 	 * @param ItemData - Item data relevant to this item type. Should contain stack count. May be null, so you should
@@ -90,7 +189,7 @@ public:
 	 * @param Count - Number of items of this type to try to add to the stack
 	 * @return Number of items added to the stack. 0 on failure
 	 */
-	virtual int32 AddToStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const { unimplemented(); return 0; }
+	virtual int32 AddToStack(FInventoryItemDataBase* ItemData, const int32 Count) const { unimplemented(); return 0; }
 
 	/**
 	 * Try to remove items from a stack of this type. Must be implemented for any type that allows stacking
@@ -99,7 +198,7 @@ public:
 	* @param Count - Number of items of this type to try to remove from stack
 	 * @return Number of items removed from the stack. 0 on failure
 	 */
-	virtual int32 RemoveFromStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const { unimplemented(); return 0; }
+	virtual int32 RemoveFromStack(FInventoryItemDataBase* ItemData, const int32 Count) const { unimplemented(); return 0; }
 
 	/**
 	 * Try set the number of items in a stack of this type - does not need to check against max stack size
@@ -107,7 +206,7 @@ public:
 	 * add an assert for validity
 	 * @param Count - Number of items of this type try to set
 	*/
-	virtual void SetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const { unimplemented(); }
+	virtual void SetStackCount(FInventoryItemDataBase* ItemData, const int32 Count) const { unimplemented(); }
 
 	/**
 	 * Used to get the number of items in a stack of this type
@@ -115,7 +214,7 @@ public:
 	 * add an assert for validity
 	 * @return Number of items stored in the stack
 	 */
-	virtual int32 GetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData) const { unimplemented(); return 0; }
+	virtual int32 GetStackCount(const FInventoryItemDataBase* ItemData) const { unimplemented(); return 0; }
 
 	/**
 	 * Compare inventory item types, default implementation only checks for matching class
@@ -124,24 +223,43 @@ public:
 
 	bool operator!=(const UInventoryItemTypeBase& OtherType) const { return !operator==(OtherType); }
 
+	/**
+	 * Hash used to group items by type. Must be overridden alongside the equality operator so that equal types always
+	 * produce equal hashes. Default implementation only hashes the class
+	 */
+	virtual uint32 GetItemTypeHash() const { return GetTypeHash(GetClass()); }
+
 
 	
 protected:
+	FInventoryItemTypeTraits TypeTraits;
+
+
 	template <typename DataType>
-	static TSharedPtr<DataType> ConvertDataChecked(TWeakPtr<FInventoryItemDataBase> ItemData)
+	static DataType* ConvertDataChecked(FInventoryItemDataBase* ItemData)
 	{
 		static_assert(TIsDerivedFrom<DataType, FInventoryItemDataBase>::IsDerived, "Conversion data type must be derived from FInventoryItemDataBase");
-		if (!ItemData.IsValid())
+		if (!ItemData || ItemData->GetScriptStruct() != DataType::StaticStruct())
 		{
 			return nullptr;
 		}
 
-		const TSharedPtr<FInventoryItemDataBase> PinnedData = ItemData.Pin();
-		if (PinnedData->GetScriptStruct() != DataType::StaticStruct())
-		{
-			return nullptr;
-		}
+		return static_cast<DataType*>(ItemData);
+	}
 
-		return StaticCastSharedPtr<DataType>(PinnedData);
+	template <typename DataType>
+	static const DataType* ConvertDataChecked(const FInventoryItemDataBase* ItemData)
+	{
+		return ConvertDataChecked<DataType>(const_cast<FInventoryItemDataBase*>(ItemData));
 	}
+
+
+private:
+	friend class FInventoryItemTypePool;
+
+	// Set for types created by the item type pool
+	bool bPooled = false;
+
+	// Number of items referencing a pooled type, which can be copied and destroyed on any thread
+	mutable FThreadSafeCounter PooledItemReferences;
 };
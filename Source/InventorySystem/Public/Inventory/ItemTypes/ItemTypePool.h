@@ -0,0 +1,78 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+
+
+// Forward declarations
+
+class UInventoryItemTypeBase;
+
+
+
+/**
+ * Pool of dynamic item type objects (types that aren't supported for networking, so each replicated item gets its own
+ * instance). Clients acquire types from the pool when replicated items need a new type object, and release them when
+ * replication removes the item, so that repeated replication of the same types doesn't create new objects.
+ * Copies of a removed item (in read snapshots, sorted views, or notifications) can outlive it, so released types are
+ * kept alive until no item refers to them anymore, and only then reset to their class defaults and handed out again
+ */
+class INVENTORYSYSTEM_API FInventoryItemTypePool : public FGCObject
+{
+public:
+	// Maximum number of free types kept for each class
+	static constexpr int32 MaxFreeTypesPerClass = 32;
+
+
+	static FInventoryItemTypePool& Get();
+
+	/**
+	 * Destroys the pool, letting any free types be garbage collected. Called on module shutdown
+	 */
+	static void Shutdown();
+
+
+	// Pool operations
+
+	/**
+	 * Returns a free type of the specified class, or creates a new one in the transient package if there are none
+	 */
+	UInventoryItemTypeBase* Acquire(UClass* TypeClass);
+
+	/**
+	 * Returns a type to the pool once the item that acquired it is done with it. Types that weren't created by the pool
+	 * are ignored, since they could still be shared
+	 */
+	void Release(UInventoryItemTypeBase* ItemType);
+
+
+	// FGCObject overrides
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FInventoryItemTypePool"); }
+
+
+private:
+	/**
+	 * Moves released types of a class that nothing refers to anymore to the free list, or lets the garbage collector
+	 * have them if the free list is full
+	 */
+	void ReclaimReleasedTypes(UClass* TypeClass);
+
+	/**
+	 * Resets a type to its class defaults, so the next item doesn't see properties that its own replicated state doesn't
+	 * overwrite
+	 */
+	static void ResetType(UInventoryItemTypeBase* ItemType);
+
+
+	TMap<UClass*, TArray<UInventoryItemTypeBase*>> FreeTypes;
+
+	// Released types that may still be referenced by copies of their items
+	TMap<UClass*, TArray<UInventoryItemTypeBase*>> ReleasedTypes;
+
+	static TUniquePtr<FInventoryItemTypePool> Instance;
+};
@@ -26,14 +26,16 @@ public:
 
 	// Item type overrides
 
+	virtual void RefreshTypeTraits() override;
 	virtual bool NetSerialize(FArchive& Ar, UPackageMap* PackageMap, bool& bOutSuccess) override;
-	virtual UScriptStruct* GetItemDataType() const override;
-	virtual TSharedPtr<FInventoryItemDataBase> CreateItemData() const override;
-	virtual bool AllowsStacking() const override { return true; }
-	virtual int32 AddToStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const override;
-	virtual int32 RemoveFromStack(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const override;
-	virtual void SetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData, const int32 Count) const override;
-	virtual int32 GetStackCount(TWeakPtr<FInventoryItemDataBase> ItemData) const override;
+
+	// Stack operations are final so that inventory items can safely bypass them using the cached type traits
+	virtual UScriptStruct* GetItemDataType() const override final;
+	virtual bool AllowsStacking() const override final { return true; }
+	virtual int32 AddToStack(FInventoryItemDataBase* ItemData, const int32 Count) const override final;
+	virtual int32 RemoveFromStack(FInventoryItemDataBase* ItemData, const int32 Count) const override final;
+	virtual void SetStackCount(FInventoryItemDataBase* ItemData, const int32 Count) const override final;
+	virtual int32 GetStackCount(const FInventoryItemDataBase* ItemData) const override final;
 
 
 	// Editor properties
@@ -0,0 +1,119 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Inventory/InventoryItem.h"
+#include "Async/Future.h"
+#include "InventoryPersistenceSubsystem.generated.h"
+
+
+// Forward declarations
+
+class FInventorySnapshot;
+class IInventoryStorageBackend;
+class UInventoryComponent;
+
+
+
+// Delegates
+
+DECLARE_DELEGATE_OneParam(FInventorySaveCompleteDelegate, bool);
+DECLARE_DELEGATE_TwoParams(FInventoryLoadCompleteDelegate, bool, TArray<FInventoryItem>&);
+
+
+
+/**
+ * Saves and loads inventories without stalling the game thread. Saves capture and encode the items on the game thread,
+ * then compress and store them on a worker. Loads read, decompress and decode on workers, and only return to the game thread
+ * to resolve item types and to hand over the finished items
+ */
+UCLASS()
+class INVENTORYSYSTEM_API UInventoryPersistenceSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Subsystem overrides
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+
+	// Storage
+
+	/**
+	 * Replaces the storage backend. Defaults to one file per inventory in the project's saved directory
+	 */
+	void SetStorageBackend(const TSharedRef<IInventoryStorageBackend, ESPMode::ThreadSafe>& InStorageBackend);
+
+
+	// Saving and loading
+
+	/**
+	 * Saves the items in an inventory. If an inventory is saved with the same key again before an earlier save finishes,
+	 * the earlier save is dropped if it would otherwise finish last
+	 * @param OnComplete - Called on the game thread with whether the save was stored
+	 */
+	void SaveInventory(const UInventoryComponent* InventoryComponent, const FString& Key,
+		FInventorySaveCompleteDelegate OnComplete = FInventorySaveCompleteDelegate());
+
+	/**
+	 * Loads saved items without applying them to anything
+	 * @param OnComplete - Called on the game thread with whether the load succeeded, and the loaded items, which may be
+	 * moved out
+	 */
+	void LoadInventory(const FString& Key, FInventoryLoadCompleteDelegate OnComplete);
+
+	/**
+	 * Loads saved items and swaps them into an inventory, if it still exists when the load finishes
+	 * @param OnComplete - Called on the game thread with whether the items were loaded
+	 */
+	void LoadInventoryInto(UInventoryComponent* InventoryComponent, const FString& Key,
+		FInventorySaveCompleteDelegate OnComplete = FInventorySaveCompleteDelegate());
+
+	
+private:
+
+	// Loading helpers
+
+	/**
+	 * Resolves the item types of a loaded snapshot, then materializes its items on a worker
+	 */
+	void MaterializeLoadedItems(const TSharedRef<FInventorySnapshot, ESPMode::ThreadSafe>& Snapshot,
+		FInventoryLoadCompleteDelegate OnComplete);
+
+	/**
+	 * Keeps a worker task so shutdown can wait for it, forgetting any tasks that already finished
+	 */
+	void TrackTask(TFuture<void>&& Task);
+
+
+	// Storage
+
+	TSharedPtr<IInventoryStorageBackend, ESPMode::ThreadSafe> StorageBackend;
+
+	// State shared with the worker tasks
+	struct FSharedState
+	{
+		FCriticalSection WriteLock;
+
+		// Highest save number that was written for each key
+		TMap<FString, uint32> WrittenSaveNumbers;
+	};
+
+	TSharedRef<FSharedState, ESPMode::ThreadSafe> SharedState = MakeShared<FSharedState, ESPMode::ThreadSafe>();
+
+	// Increasing number given to each save, used to order saves with the same key
+	uint32 NextSaveNumber = 1;
+
+	// Worker tasks that may still be running, so shutdown can wait for saves to finish
+	TArray<TFuture<void>> PendingTasks;
+
+	// Item types resolved by loads in progress, kept alive until the loaded items are handed over. May contain
+	// duplicates when loads share types
+	UPROPERTY(Transient)
+	TArray<UInventoryItemTypeBase*> PendingLoadTypes;
+};
@@ -0,0 +1,53 @@
+﻿// Copyright (c) 2020 Spencer Melnick
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+/**
+ * Storage for saved inventories, keyed by a name chosen by the game such as a player ID. Backends are called from worker
+ * threads, so implementations must be thread safe
+ */
+class INVENTORYSYSTEM_API IInventoryStorageBackend
+{
+public:
+	virtual ~IInventoryStorageBackend() = default;
+
+	/**
+	 * Stores saved inventory data, replacing anything previously stored with the same key
+	 * @return True if the data was stored
+	 */
+	virtual bool WriteInventory(const FString& Key, const TArray<uint8>& Data) = 0;
+
+	/**
+	 * Reads saved inventory data
+	 * @return True if data was found for the key
+	 */
+	virtual bool ReadInventory(const FString& Key, TArray<uint8>& OutData) = 0;
+};
+
+
+
+/**
+ * Storage backend that keeps each inventory in its own file, mostly meant for testing and listen servers
+ */
+class INVENTORYSYSTEM_API FInventoryFileStorageBackend : public IInventoryStorageBackend
+{
+public:
+	/**
+	 * @param InDirectory - Directory to keep the files in, created when the first inventory is written
+	 */
+	explicit FInventoryFileStorageBackend(const FString& InDirectory)
+		: Directory(InDirectory) {}
+
+	virtual bool WriteInventory(const FString& Key, const TArray<uint8>& Data) override;
+	virtual bool ReadInventory(const FString& Key, TArray<uint8>& OutData) override;
+
+
+private:
+	FString GetFilePath(const FString& Key) const;
+
+	FString Directory;
+};
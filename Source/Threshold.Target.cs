@@ -9,6 +9,7 @@ public class ThresholdTarget : TargetRules
 	{
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
+		bWithPushModel = true;
 		ExtraModuleNames.AddRange(new string [] { "ThresholdGame", "ThresholdUI", "InventorySystem" } );
 	}
 }
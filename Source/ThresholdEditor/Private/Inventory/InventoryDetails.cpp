@@ -151,15 +151,15 @@ void FInventoryItemDetails::UpdateDataStruct()
 	// Access the item handle from the property
 	FInventoryItem* Item = GetItem();
 
-	if (!Item || !Item->Data.IsValid() || !Item->Data->GetScriptStruct())
+	if (!Item || !Item->Data.IsValid())
 	{
 		return;
 	}
 
-	UScriptStruct* ItemDataType = Item->Data->GetScriptStruct();
+	UScriptStruct* ItemDataType = Item->Data.GetScriptStruct();
 	
 	// Add access to the internal data struct
-	const TSharedRef<FStructOnScope> InternalStruct = MakeShared<FStructOnScope>(ItemDataType, reinterpret_cast<uint8*>(Item->Data.Get()));
+	const TSharedRef<FStructOnScope> InternalStruct = MakeShared<FStructOnScope>(ItemDataType, reinterpret_cast<uint8*>(Item->Data.GetMutable()));
 	IDetailPropertyRow* StructProperty = ChildBuilder->AddExternalStructure(InternalStruct);
 
 	// Set up delegate to mark property as dirty when internal struct changes
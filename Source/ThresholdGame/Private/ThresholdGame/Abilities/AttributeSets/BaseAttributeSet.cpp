@@ -4,6 +4,7 @@
 #include "GameplayEffect.h"
 #include "GameplayEffectExtension.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 
 // UBaseAttributeSet
@@ -19,6 +20,15 @@ void UBaseAttributeSet::PreAttributeChange(const FGameplayAttribute& Attribute,
 		// Limit health by the new max health
 		LimitAttributeOnMaxChange(Health, GetHealthAttribute(), NewValue);
 	}
+
+	MarkAttributeDirty(Attribute);
+}
+
+void UBaseAttributeSet::PreAttributeBaseChange(const FGameplayAttribute& Attribute, float& NewValue) const
+{
+	Super::PreAttributeBaseChange(Attribute, NewValue);
+
+	MarkAttributeDirty(Attribute);
 }
 
 void UBaseAttributeSet::PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data)
@@ -58,9 +68,13 @@ void UBaseAttributeSet::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 	
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Health, COND_None, REPNOTIFY_Always)
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, MaxHealth, COND_None, REPNOTIFY_Always)
-	DOREPLIFETIME_CONDITION_NOTIFY(UBaseAttributeSet, Defense, COND_None, REPNOTIFY_Always)
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.RepNotifyCondition = REPNOTIFY_Always;
+	
+	DOREPLIFETIME_WITH_PARAMS_FAST(UBaseAttributeSet, Health, Params)
+	DOREPLIFETIME_WITH_PARAMS_FAST(UBaseAttributeSet, MaxHealth, Params)
+	DOREPLIFETIME_WITH_PARAMS_FAST(UBaseAttributeSet, Defense, Params)
 }
 
 void UBaseAttributeSet::OnRep_Health(const FGameplayAttributeData& OldHealth)
@@ -102,4 +116,18 @@ void UBaseAttributeSet::LimitAttributeOnMaxChange(FGameplayAttributeData& Attrib
 	}
 }
 
-
+void UBaseAttributeSet::MarkAttributeDirty(const FGameplayAttribute& Attribute) const
+{
+	if (Attribute == GetHealthAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UBaseAttributeSet, Health, this);
+	}
+	else if (Attribute == GetMaxHealthAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UBaseAttributeSet, MaxHealth, this);
+	}
+	else if (Attribute == GetDefenseAttribute())
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(UBaseAttributeSet, Defense, this);
+	}
+}
@@ -58,6 +58,13 @@ void UInteractAbility::ActivateAbility(
 		{
 			// Send target object data on the predicting client
 			SendTargetDataToServer(new FSingleObjectTargetData(TargetObject.GetObject()));
+
+			// The server triggers the interaction under the same activation key, which settles the prediction
+			ABaseCharacter* BaseCharacter = UAbilityFunctionLibrary::GetCharacterFromActorInfo<ABaseCharacter>(ActorInfo);
+			if (TargetObject->CanInteract(BaseCharacter))
+			{
+				TargetObject->OnPredictInteract(BaseCharacter, ActivationInfo.GetActivationPredictionKey());
+			}
 		}
 		else
 		{
@@ -161,7 +168,7 @@ void UInteractAbility::TriggerInteraction(TWeakInterfacePtr<IInteractiveObject>
 		return;
 	}
 
-	Object->OnServerInteract(BaseCharacter);
+	Object->OnServerInteract(BaseCharacter, CurrentActivationInfo.GetActivationPredictionKey());
 	EndAbility(CurrentSpecHandle, CurrentActorInfo, CurrentActivationInfo, true, false);
 }
 
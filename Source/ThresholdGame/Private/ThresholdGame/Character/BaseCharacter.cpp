@@ -4,6 +4,7 @@
 #include "Engine/SkeletalMeshSocket.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "ThresholdGame.h"
 #include "ThresholdGame/Character/Movement/THCharacterMovement.h"
 #include "ThresholdGame/Abilities/THAbilitySystemComponent.h"
@@ -144,7 +145,10 @@ void ABaseCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLi
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ABaseCharacter, EquippedWeapon)
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ABaseCharacter, EquippedWeapon, Params)
 }
 
 
@@ -293,6 +297,7 @@ void ABaseCharacter::EquipWeapon(AActor* NewWeapon)
 	}
 
 	EquippedWeapon = NewWeaponBase;
+	MARK_PROPERTY_DIRTY_FROM_NAME(ABaseCharacter, EquippedWeapon, this);
 }
 
 void ABaseCharacter::UnequipWeapon()
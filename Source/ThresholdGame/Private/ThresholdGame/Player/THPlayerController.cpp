@@ -14,6 +14,8 @@
 #include "GameFramework/HUD.h"
 #include "EngineUtils.h"
 #include "Inventory/InventoryItem.h"
+#include "Inventory/Components/InventoryComponent.h"
+#include "Inventory/Components/InventoryOwner.h"
 
 
 
@@ -77,6 +79,7 @@ void ATHPlayerController::Tick(float DeltaTime)
 	if (IsLocalController())
 	{
 		CheckInteractiveObjects();
+		UpdatePendingPickupNotifications();
 	}
 }
 
@@ -219,21 +222,70 @@ void ATHPlayerController::ToggleMenu()
 	SetPawnInputEnabled(PlayerHUD->ShouldEnableCharacterControl());
 }
 
-void ATHPlayerController::ClientShowItemPickupNotification_Implementation(FInventoryItem Item)
+void ATHPlayerController::ClientShowItemPickupNotification_Implementation(const FInventoryItemNetReference& ItemReference)
 {
-	if (!Item.IsValid())
+	if (!ItemReference.IsValid())
 	{
 		UE_LOG(LogThresholdGame, Error, TEXT("ATHPlayerController::ClientShowItemPickupNotification failed on %s - invalid item"),
 			*GetNameSafe(this))
 		return;
 	}
 
+	if (!TryShowItemPickupNotification(ItemReference))
+	{
+		// The inventory replicates separately from this RPC, so the item may not have arrived yet
+		PendingPickupNotifications.Emplace(ItemReference, GetWorld()->GetTimeSeconds());
+	}
+}
+
+UInventoryComponent* ATHPlayerController::GetInventoryComponent() const
+{
+	const IInventoryOwner* InventoryOwner = Cast<IInventoryOwner>(PlayerState);
+	return InventoryOwner ? InventoryOwner->GetInventoryComponent() : nullptr;
+}
+
+bool ATHPlayerController::TryShowItemPickupNotification(const FInventoryItemNetReference& ItemReference)
+{
+	FInventoryItem Item;
+	if (!ItemReference.Resolve(GetInventoryComponent(), Item))
+	{
+		return false;
+	}
+
 	IHUDControl* PlayerHUD = GetHUD<IHUDControl>();
-	if (!PlayerHUD)
+	if (PlayerHUD)
+	{
+		PlayerHUD->ShowItemPickupNotification(Item);
+	}
+	return true;
+}
+
+void ATHPlayerController::UpdatePendingPickupNotifications()
+{
+	if (PendingPickupNotifications.Num() == 0)
 	{
 		return;
 	}
-	PlayerHUD->ShowItemPickupNotification(Item);
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Keep the notifications in the order they were received
+	PendingPickupNotifications.RemoveAll([this, CurrentTime](const TPair<FInventoryItemNetReference, float>& PendingNotification)
+	{
+		if (TryShowItemPickupNotification(PendingNotification.Key))
+		{
+			return true;
+		}
+
+		if (CurrentTime - PendingNotification.Value > PickupNotificationTimeout)
+		{
+			UE_LOG(LogThresholdGame, Warning, TEXT("ATHPlayerController::ClientShowItemPickupNotification on %s - picked up item never replicated"),
+				*GetNameSafe(this))
+			return true;
+		}
+
+		return false;
+	});
 }
 
 
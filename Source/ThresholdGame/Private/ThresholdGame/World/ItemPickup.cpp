@@ -70,8 +70,19 @@ void AItemPickup::AttachInteractionIndicator(AActor* Indicator)
 	Indicator->AttachToComponent(RootComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
 }
 
+void AItemPickup::OnPredictInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey)
+{
+	IInventoryOwner* InventoryOwner = Cast<IInventoryOwner>(Character);
+	if (!InventoryOwner || !InventoryItem.IsValid())
+	{
+		return;
+	}
+
+	// Show the item in the inventory straight away, instead of waiting for the server's items to replicate
+	InventoryOwner->PredictAddItem(InventoryItem, PredictionKey);
+}
 
-void AItemPickup::OnServerInteract(ABaseCharacter* Character)
+void AItemPickup::OnServerInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey)
 {
 	UE_LOG(LogThresholdGame, Display, TEXT("%s picked up %s"), *GetNameSafe(Character), *GetNameSafe(this))
 
@@ -80,7 +91,8 @@ void AItemPickup::OnServerInteract(ABaseCharacter* Character)
 	{
 		return;
 	}
-	const IInventoryOwner::FAdditionResult AdditionResult = InventoryOwner->AddItem(InventoryItem);
+	// Acknowledges the client's prediction along with the new items
+	const IInventoryOwner::FAdditionResult AdditionResult = InventoryOwner->PredictAddItem(InventoryItem, PredictionKey);
 
 	if (AdditionResult.Key > 0)
 	{
@@ -89,13 +101,15 @@ void AItemPickup::OnServerInteract(ABaseCharacter* Character)
 		ATHPlayerController* PlayerController = Character->GetController<ATHPlayerController>();
 		if (PlayerController)
 		{
-			// Make a copy of our item, but set its stack size to the count the player actually received if possible
-			FInventoryItem ItemCopy = InventoryItem;
-			if (ItemCopy.AllowsDuplicates())
+			// The handle refers to the new item or the stack the items went onto, and the count is what the player
+			// actually received. If the addition was batched the item may not have a replication ID yet, in which case
+			// the reference falls back to the item type
+			const FInventoryItemNetReference ItemReference(AdditionResult.Value, AdditionResult.Key);
+
+			if (ItemReference.IsValid())
 			{
-				ItemCopy.SetStackCount(AdditionResult.Key);
+				PlayerController->ClientShowItemPickupNotification(ItemReference);
 			}
-			PlayerController->ClientShowItemPickupNotification(ItemCopy);
 		}
 	}
 }
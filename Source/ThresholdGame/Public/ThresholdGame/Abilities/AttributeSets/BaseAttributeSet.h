@@ -28,6 +28,7 @@ public:
 	// Attribute set overrides
 
 	virtual void PreAttributeChange(const FGameplayAttribute& Attribute, float& NewValue) override;
+	virtual void PreAttributeBaseChange(const FGameplayAttribute& Attribute, float& NewValue) const override;
 	virtual void PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data) override;
 
 
@@ -64,6 +65,9 @@ protected:
 	// Helper functions
 
 	void LimitAttributeOnMaxChange(FGameplayAttributeData& AttributeData, FGameplayAttribute AttributeProperty, float NewMax) const;
+
+	// Marks a replicated attribute dirty for push model replication - both the base and current values are replicated
+	void MarkAttributeDirty(const FGameplayAttribute& Attribute) const;
 	
 	
 	
@@ -68,5 +68,5 @@ public:
 	/**
 	 * Tells the HUD to show a notification that the local player picked up an item
 	 */
-	virtual void ShowItemPickupNotification(FInventoryItem& Item) = 0;
+	virtual void ShowItemPickupNotification(const FInventoryItem& Item) = 0;
 };
@@ -7,7 +7,7 @@
 #include "UObject/WeakInterfacePtr.h"
 #include "ThresholdGame/Character/BaseCharacter.h"
 #include "ThresholdGame/Effects/Camera/THPlayerCameraManager.h"
-#include "Inventory/InventoryItem.h"
+#include "Inventory/InventoryItemReference.h"
 #include "THPlayerController.generated.h"
 
 
@@ -17,6 +17,7 @@
 class ICombatant;
 class IInteractiveObject;
 struct FInventoryItem;
+class UInventoryComponent;
 
 
 
@@ -51,8 +52,12 @@ public:
 
 	void ToggleMenu();
 
+	/**
+	 * Shows a notification for items the player picked up. The items are referenced in the player's replicated
+	 * inventory instead of being sent again, so the notification waits for them to replicate if needed
+	 */
 	UFUNCTION(Client, Reliable)
-	void ClientShowItemPickupNotification(FInventoryItem Item);
+	void ClientShowItemPickupNotification(const FInventoryItemNetReference& ItemReference);
 
 
 
@@ -96,6 +101,10 @@ public:
 	// Actor class for interaction indicator
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Interaction")
 	TSubclassOf<AActor> InteractionIndicatorClass;
+
+	// Seconds to wait for picked up items to replicate before their notifications are dropped
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Interaction")
+	float PickupNotificationTimeout = 2.f;
 	
 	
 
@@ -105,6 +114,16 @@ protected:
 	void CheckInteractiveObjects();
 	void SetCurrentInteractiveObject(TWeakInterfacePtr<IInteractiveObject> NewObject);
 
+	UInventoryComponent* GetInventoryComponent() const;
+
+	/**
+	 * Shows the pickup notification for an item reference if it can be resolved
+	 * @return False if the referenced item hasn't replicated yet
+	 */
+	bool TryShowItemPickupNotification(const FInventoryItemNetReference& ItemReference);
+
+	void UpdatePendingPickupNotifications();
+
 	
 	// UI initialization
 
@@ -126,6 +145,13 @@ private:
 
 
 
+	// Pickup notifications
+
+	// References that couldn't be resolved yet, along with the time they were received
+	TArray<TPair<FInventoryItemNetReference, float>> PendingPickupNotifications;
+
+
+
 	// Input control
 
 	bool bPawnInputEnabled = true;
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameplayPrediction.h"
 #include "InteractiveObject.generated.h"
 
 
@@ -32,6 +33,10 @@ public:
 	virtual FVector GetInteractLocation() const = 0;
 	virtual void AttachInteractionIndicator(AActor* Indicator);
 
-	// Called when the server actually runs the interaction
-	virtual void OnServerInteract(ABaseCharacter* Character) = 0;
+	// Called on the owning client when it predicts the interaction, ahead of the server. Changes made here should be
+	// tied to the prediction key, so that they're undone if the server doesn't agree
+	virtual void OnPredictInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey) {}
+
+	// Called when the server actually runs the interaction, with the key the owning client predicted it under
+	virtual void OnServerInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey) = 0;
 };
@@ -37,7 +37,8 @@ public:
 	virtual bool CanInteract(ABaseCharacter* Character) const override;
 	virtual FVector GetInteractLocation() const override;
 	virtual void AttachInteractionIndicator(AActor* Indicator) override;
-	virtual void OnServerInteract(ABaseCharacter* Character) override;
+	virtual void OnPredictInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey) override;
+	virtual void OnServerInteract(ABaseCharacter* Character, const FPredictionKey& PredictionKey) override;
 
 	
 	// Component names
@@ -11,7 +11,7 @@ public class ThresholdGame : ModuleRules
 		PublicDependencyModuleNames.AddRange(new string[]
         {
             "GameplayAbilities", "GameplayTags", "GameplayTasks", "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay",
-            "Niagara", "InventorySystem"
+            "Niagara", "InventorySystem", "NetCore"
         });
 
         PublicIncludePaths.AddRange(new string[] {"ThresholdGame/Public"});
@@ -70,7 +70,7 @@ bool APlayerHUD::ShouldEnableCharacterControl() const
 	}
 }
 
-void APlayerHUD::ShowItemPickupNotification(FInventoryItem& Item)
+void APlayerHUD::ShowItemPickupNotification(const FInventoryItem& Item)
 {
 	if (!GameOverlay)
 	{
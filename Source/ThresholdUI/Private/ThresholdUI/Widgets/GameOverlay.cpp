@@ -10,7 +10,7 @@
 
 // UGameOverlay
 
-void UGameOverlay::ShowItemPickupNotification(FInventoryItem& Item)
+void UGameOverlay::ShowItemPickupNotification(const FInventoryItem& Item)
 {
 	CHECK_WIDGET_STATEMENT(PickupNotificationSlot)
 
@@ -64,7 +64,7 @@ void UInventoryBlock::DisplayItem(FInventoryArrayHandle InItemHandle)
 	DisplayItem(*InventoryItem);
 }
 
-void UInventoryBlock::DisplayItem(FInventoryItem& InItem)
+void UInventoryBlock::DisplayItem(const FInventoryItem& InItem)
 {
 	#if WITH_EDITOR
 		if (!StackDisplay || !ThumbnailDisplay)
@@ -156,7 +156,7 @@ void UInventoryBlock::InitializeSelection(TScriptInterface<ISelectionController>
 
 // Helper functions
 
-FText UInventoryBlock::GetStackText(FInventoryItem* InventoryItem)
+FText UInventoryBlock::GetStackText(const FInventoryItem* InventoryItem)
 {
 	if (!InventoryItem || !InventoryItem->AllowsStacking())
 	{
@@ -54,8 +54,14 @@ void UInventoryGrid::AssignInventoryComponent(UInventoryComponent* InInventoryCo
 
 	if (InventoryComponent != nullptr)
 	{
-		// Clear update from previous inventory component delegate
-		InventoryComponent->OnInventoryChanged.RemoveDynamic(this, &UInventoryGrid::UpdateDisplay);
+		// Clear updates from previous inventory component delegates
+		InventoryComponent->OnItemAdded.RemoveDynamic(this, &UInventoryGrid::OnItemAddedOrRemoved);
+		InventoryComponent->OnItemRemoved.RemoveDynamic(this, &UInventoryGrid::OnItemAddedOrRemoved);
+		InventoryComponent->OnItemChanged.RemoveDynamic(this, &UInventoryGrid::UpdateItemDisplay);
+		InventoryComponent->OnInventoryChanged.RemoveDynamic(this, &UInventoryGrid::OnInventoryChanged);
+
+		// Stop streaming the pages we were displaying
+		InventoryComponent->SubscribeToPages(TArray<int32>());
 	}
 
 	// Assign properties to new values
@@ -63,13 +69,19 @@ void UInventoryGrid::AssignInventoryComponent(UInventoryComponent* InInventoryCo
 
 	if (InventoryComponent)
 	{
-		InventoryComponent->OnInventoryChanged.AddUniqueDynamic(this, &UInventoryGrid::UpdateDisplay);
+		// Modified items only need their own block updated, but additions and removals shift the whole grid
+		InventoryComponent->OnItemAdded.AddUniqueDynamic(this, &UInventoryGrid::OnItemAddedOrRemoved);
+		InventoryComponent->OnItemRemoved.AddUniqueDynamic(this, &UInventoryGrid::OnItemAddedOrRemoved);
+		InventoryComponent->OnItemChanged.AddUniqueDynamic(this, &UInventoryGrid::UpdateItemDisplay);
+		InventoryComponent->OnInventoryChanged.AddUniqueDynamic(this, &UInventoryGrid::OnInventoryChanged);
 	}
 }
 
 
 void UInventoryGrid::UpdateDisplay()
 {
+	bLayoutDirty = false;
+
 	if (!InventoryComponent)
 	{
 		for (UInventoryBlock* InventoryBlock : SubBlocks)
@@ -80,26 +92,101 @@ void UInventoryGrid::UpdateDisplay()
 		return;
 	}
 
-	TArray<FInventoryArrayHandle> ItemHandles = InventoryComponent->GetArrayHandles();
-	int32 HandleIndex = 0;
+	int32 BlockIndex = 0;
 
-	// Update all sub blocks
-	for (UInventoryBlock* InventoryBlock : SubBlocks)
+	if (bSortItems)
 	{
-		if (HandleIndex >= ItemHandles.Num())
+		// The component maintains the sorted order incrementally, so this doesn't sort anything in the common case
+		for (const int32 ItemID : InventoryComponent->GetSortedItemIDs(SortMode))
 		{
-			InventoryBlock->ClearDisplay();
+			if (BlockIndex >= SubBlocks.Num())
+			{
+				break;
+			}
+
+			SubBlocks[BlockIndex++]->DisplayItem(InventoryComponent->GetItemByID(ItemID));
 		}
-		else
+	}
+	else
+	{
+		// Fill the sub blocks with items in order, without copying out the item handles
+		InventoryComponent->ForEachItemHandle([this, &BlockIndex](const FInventoryArrayHandle& ItemHandle)
+		{
+			if (BlockIndex >= SubBlocks.Num())
+			{
+				return false;
+			}
+
+			SubBlocks[BlockIndex++]->DisplayItem(ItemHandle);
+			return true;
+		});
+	}
+
+	// Clear any remaining sub blocks
+	for (; BlockIndex < SubBlocks.Num(); BlockIndex++)
+	{
+		SubBlocks[BlockIndex]->ClearDisplay();
+	}
+
+	if (InventoryComponent->GetReplicationPageSize() > 0)
+	{
+		// Paginated inventories only replicate the pages someone is looking at in full. Cells follow the sorted or array
+		// order rather than the slot order, so subscribe to the pages of the items actually on display
+		TArray<int32> DisplayedPages;
+
+		for (UInventoryBlock* InventoryBlock : SubBlocks)
 		{
-			InventoryBlock->DisplayItem(ItemHandles[HandleIndex++]);
+			const FInventoryArrayHandle ItemHandle = InventoryBlock->GetItemHandle();
+
+			if (!ItemHandle.IsNull())
+			{
+				DisplayedPages.AddUnique(InventoryComponent->GetItemReplicationPage(ItemHandle.GetItemID()));
+			}
 		}
+
+		DisplayedPages.Sort();
+		InventoryComponent->SubscribeToPages(DisplayedPages);
 	}
 
 	// Notify the parent that our selection has potentially changed (because the underlying item handle might have changed)
 	InventoryGridSelectedDelegate.ExecuteIfBound(GetSelectedItem());
 }
 
+void UInventoryGrid::UpdateItemDisplay(int32 ItemID)
+{
+	if (bLayoutDirty)
+	{
+		// The whole grid is going to be updated anyways
+		return;
+	}
+
+	if (bSortItems)
+	{
+		// Changes can move the item within the sorted order, so lay out the grid again once the changes are done
+		bLayoutDirty = true;
+		return;
+	}
+
+	const FInventoryArrayHandle SelectedItem = GetSelectedItem();
+
+	for (UInventoryBlock* InventoryBlock : SubBlocks)
+	{
+		const FInventoryArrayHandle ItemHandle = InventoryBlock->GetItemHandle();
+
+		if (!ItemHandle.IsNull() && ItemHandle.GetItemID() == ItemID)
+		{
+			InventoryBlock->DisplayItem(ItemHandle);
+
+			if (ItemHandle.GetItemID() == SelectedItem.GetItemID())
+			{
+				// Let the parent refresh its details of the selected item
+				InventoryGridSelectedDelegate.ExecuteIfBound(ItemHandle);
+			}
+			return;
+		}
+	}
+}
+
 
 
 // Initialization
@@ -327,3 +414,20 @@ void UInventoryGrid::Reconstruct()
 	UpdateDisplay();
 }
 
+
+
+// Delegate functions
+
+void UInventoryGrid::OnItemAddedOrRemoved(int32 ItemID)
+{
+	bLayoutDirty = true;
+}
+
+void UInventoryGrid::OnInventoryChanged()
+{
+	if (bLayoutDirty)
+	{
+		UpdateDisplay();
+	}
+}
+
@@ -10,7 +10,7 @@
 
 // Display controls
 
-void UPickupNotification::SetDisplayedItem(FInventoryItem& Item)
+void UPickupNotification::SetDisplayedItem(const FInventoryItem& Item)
 {
 	#if WITH_EDITOR
 		if (!ItemDisplay || !TextDisplay)
@@ -44,7 +44,7 @@ public:
 
 	virtual EPlayerHUDStatus GetStatus() const override { return Status; }
 	virtual bool ShouldEnableCharacterControl() const override;
-	virtual void ShowItemPickupNotification(FInventoryItem& Item) override;
+	virtual void ShowItemPickupNotification(const FInventoryItem& Item) override;
 	virtual void OnPlayerStateInitialized() override;
 
 
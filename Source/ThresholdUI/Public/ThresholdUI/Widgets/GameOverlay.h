@@ -29,7 +29,7 @@ public:
 
 	// Overlay controls
 
-	void ShowItemPickupNotification(FInventoryItem& Item);
+	void ShowItemPickupNotification(const FInventoryItem& Item);
 
 
 	// Editor properties
@@ -48,7 +48,7 @@ public:
 	 * Displays a specific item in an inventory
 	 * @param InItem - Pointer to the item to be displayed - will clear display if invalid
 	*/
-	void DisplayItem(FInventoryItem& InItem);
+	void DisplayItem(const FInventoryItem& InItem);
 
 	/**
 	 * Clears the item display and item handle
@@ -102,7 +102,7 @@ protected:
 
 	// Helper functions
 	
-	static FText GetStackText(FInventoryItem* InventoryItem);
+	static FText GetStackText(const FInventoryItem* InventoryItem);
 	void SetBrushTexture(TSoftObjectPtr<UTexture2D> Texture);
 
 	
@@ -6,6 +6,7 @@
 #include "Blueprint/UserWidget.h"
 #include "ThresholdUI/Interfaces/PlayerWidget.h"
 #include "ThresholdUI/Interfaces/SelectableWidget.h"
+#include "Inventory/InventorySortIndex.h"
 #include "InventoryGrid.generated.h"
 
 
@@ -60,6 +61,12 @@ public:
 	UFUNCTION()
 	void UpdateDisplay();
 
+	/**
+	 * Updates only the inventory block displaying a specific item, if any
+	 */
+	UFUNCTION()
+	void UpdateItemDisplay(int32 ItemID);
+
 
 	// Initialization
 
@@ -132,6 +139,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=InventoryGrid)
 	TEnumAsByte<EVerticalAlignment> VerticalAlignment;
 
+	// Whether to display items in sorted order instead of inventory order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=InventoryGrid)
+	bool bSortItems = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=InventoryGrid, meta=(EditCondition="bSortItems"))
+	EInventorySortMode SortMode = EInventorySortMode::Name;
+
 
 protected:
 
@@ -147,6 +161,21 @@ protected:
 	 * Constructs sub inventory blocks and updates their displays
 	 */
 	void Reconstruct();
+
+
+	// Delegate functions
+
+	/**
+	 * Called when an item is added or removed, which shifts the items in the grid
+	 */
+	UFUNCTION()
+	void OnItemAddedOrRemoved(int32 ItemID);
+
+	/**
+	 * Called once after any batch of inventory changes, to rebuild the grid if items were added or removed
+	 */
+	UFUNCTION()
+	void OnInventoryChanged();
 	
 
 
@@ -173,6 +202,9 @@ private:
 	FIntPoint PreviousGridSize = FIntPoint::ZeroValue;
 	FIntPoint SelectedCell = FIntPoint::ZeroValue;
 
+	// Set when items were added or removed since the last full update
+	bool bLayoutDirty = false;
+
 	UPROPERTY()
 	TScriptInterface<ISelectionController> SelectionController;
 };
@@ -29,7 +29,7 @@ public:
 	// Display controls
 
 	// Updates the text and thumbnail to show the details of a specific item
-	void SetDisplayedItem(FInventoryItem& Item);
+	void SetDisplayedItem(const FInventoryItem& Item);
 
 	
 	// Editor properties